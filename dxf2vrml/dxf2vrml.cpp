@@ -156,7 +156,8 @@ main(int argc, char **argv)
   dimeModel model;
 
   if (!model.read(&in)) {
-    fprintf(stderr,"DXF read error in line: %d\n", in.getFilePosition());
+    fprintf(stderr,"DXF read error in line: %lld\n",
+            (long long) in.getFilePosition());
     return -1;
   }
 
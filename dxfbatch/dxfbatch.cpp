@@ -0,0 +1,178 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+//
+// dxfbatch - reads (and optionally converts) many DXF files on a pool
+// of worker threads, and reports the throughput.
+//
+
+#include <dime/BatchLoader.h>
+#include <dime/Input.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int 
+usage(char *progname)
+{
+  fprintf(stderr,
+	  "Usage: %s [options] [files...]\n\n"
+	  "Options:\n"
+	  "-j <num>     Number of files read at the same time\n"
+	  "             (default is the number of hardware threads)\n"
+	  "-f <file>    Read the file names from <file>, one per line\n"
+	  "             (- reads them from stdin)\n"
+	  "-o <dir>     Write each file read to <dir>\n"
+	  "-b           Write binary DXF files\n"
+	  "-m           Memory map the input files\n"
+	  "-v           Print the result of each file\n\n",
+	  progname);
+  return -1;
+}
+
+//
+// adds the file, with an output file in outdir if outdir is not NULL
+//
+
+static void
+add_file(dimeBatchLoader &loader, const char *filename, const char *outdir)
+{
+  if (outdir == NULL) {
+    loader.addFile(filename);
+    return;
+  }
+  const char *base = filename;
+  for (const char *p = filename; *p; p++) {
+    if (*p == '/' || *p == '\\') base = p + 1;
+  }
+  size_t len = strlen(outdir) + strlen(base) + 2;
+  char *outfile = new char[len];
+  snprintf(outfile, len, "%s/%s", outdir, base);
+  loader.addFile(filename, outfile);
+  delete [] outfile;
+}
+
+static bool
+add_file_list(dimeBatchLoader &loader, const char *listfile,
+              const char *outdir)
+{
+  FILE *fp = strcmp(listfile, "-") ? fopen(listfile, "r") : stdin;
+  if (!fp) {
+    fprintf(stderr,"Error opening file list for reading: %s\n", listfile);
+    return false;
+  }
+  char line[4096];
+  while (fgets(line, sizeof(line), fp)) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r')) {
+      line[--len] = 0;
+    }
+    if (len > 0) add_file(loader, line, outdir);
+  }
+  if (fp != stdin) fclose(fp);
+  return true;
+}
+
+int
+main(int argc, char **argv)
+{
+  dimeBatchLoader loader;
+  const char *outdir = NULL;
+  const char *listfile = NULL;
+  bool verbose = false;
+  int i;
+
+  // the output directory is needed before files are added
+  for (i = 1; i < argc - 1; i++) {
+    if (!strcmp(argv[i], "-o")) outdir = argv[i+1];
+  }
+
+  for (i = 1; i < argc; i++) {
+    if (argv[i][0] != '-' || argv[i][1] == 0) {
+      add_file(loader, argv[i], outdir);
+    }
+    else {
+      switch (argv[i][1]) {
+      case 'j':
+	i++;
+	if (i >= argc) return usage(argv[0]);
+	loader.setNumThreads(atoi(argv[i]));
+	break;
+      case 'f':
+	i++;
+	if (i >= argc || listfile != NULL) return usage(argv[0]);
+	listfile = argv[i];
+	if (!add_file_list(loader, listfile, outdir)) return -1;
+	break;
+      case 'o':
+	i++;
+	if (i >= argc) return usage(argv[0]);
+	break;
+      case 'b':
+	loader.setBinaryOutput(true);
+	break;
+      case 'm':
+	loader.setInputFlags(DIME_INPUT_MMAP);
+	break;
+      case 'v':
+	verbose = true;
+	break;
+      default:
+	return usage(argv[0]);
+      }
+    }
+  }
+  if (loader.getNumFiles() == 0) return usage(argv[0]);
+
+  int failed = loader.run();
+
+  for (i = 0; i < loader.getNumFiles(); i++) {
+    if (!loader.isLoaded(i)) {
+      fprintf(stderr, "%s: %s\n", loader.getFilename(i), loader.getError(i));
+    }
+    else if (verbose) {
+      printf("%s: %llu bytes in %.3f s\n", loader.getFilename(i),
+	     loader.getFileSize(i), loader.getLoadTime(i));
+    }
+  }
+
+  double secs = loader.getElapsedTime();
+  double mb = (double) loader.getTotalBytes() / (1024.0 * 1024.0);
+  int numfiles = loader.getNumFiles();
+  printf("%d files, %d failed, %.1f MB in %.2f s using %d threads",
+	 numfiles, failed, mb, secs, loader.getNumThreads());
+  if (secs > 0.0) {
+    printf(" (%.1f MB/s, %.1f files/s)", mb / secs, numfiles / secs);
+  }
+  printf("\n");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+//
+// dxfbench - times the number parser of dimeInput against the atof()
+// based parser dime used before, and the reading of DXF files. Build
+// it from two versions of the library to compare them.
+//
+
+#include <dime/Input.h>
+#include <dime/Model.h>
+#include <dime/Output.h>
+#include <dime/records/Record.h>
+#include <dime/util/Array.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <chrono>
+#include <random>
+#include <string>
+
+static int 
+usage(char *progname)
+{
+  fprintf(stderr,
+	  "Usage: %s [options] [files...]\n\n"
+	  "Times the number parser, and the reading of each file.\n\n"
+	  "Options:\n"
+	  "-n <num>     Number of runs, the fastest is reported (default 5)\n"
+	  "-c <num>     Number of values in the number benchmark\n"
+	  "             (default 2000000, 0 skips it)\n"
+	  "-m           Memory map the input files\n"
+	  "-b           Also time a binary copy of each file, written to\n"
+	  "             dxfbench.dxb in the current directory\n\n",
+	  progname);
+  return -1;
+}
+
+static double
+now()
+{
+  return std::chrono::duration<double>
+    (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//
+// Reads a number from the line at p like readReal() and readInteger()
+// did before std::from_chars() was used: the characters are copied to
+// a buffer one by one, and converted with atof(). Moves p to the next
+// line.
+//
+
+static double
+reference_atof(const char *&p)
+{
+  char str[512];
+  int n = 0;
+  while (*p == ' ' || *p == '\t') p++;
+  while (n < (int) sizeof(str) - 1 &&
+	 (isdigit((unsigned char) *p) || *p == '-' || *p == '+' ||
+	  *p == '.' || *p == 'e' || *p == 'E')) {
+    str[n++] = *p++;
+  }
+  str[n] = 0;
+  while (*p && *p++ != '\n');
+  return atof(str);
+}
+
+//
+// Times reading count coordinates, as pairs of group code and value
+// lines, with the old parser and with dimeInput.
+//
+
+static bool
+bench_numbers(const int count, const int runs)
+{
+  std::mt19937_64 rng(1);
+  std::uniform_real_distribution<double> dist(-1.0e6, 1.0e6);
+  std::string data;
+  char tmp[64];
+  for (int i = 0; i < count; i++) {
+    snprintf(tmp, sizeof(tmp), " 10\n%.15g\n", dist(rng));
+    data += tmp;
+  }
+
+  double best_old = 1e30, best_new = 1e30;
+  double sum_old = 0.0, sum_new = 0.0;
+  for (int run = 0; run < runs; run++) {
+    double t = now();
+    const char *p = data.c_str();
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+      (void) reference_atof(p); // the group code
+      sum += reference_atof(p);
+    }
+    t = now() - t;
+    if (t < best_old) best_old = t;
+    sum_old = sum;
+
+    dimeInput in;
+    if (!in.setBuffer(data.data(), data.size())) return false;
+    t = now();
+    sum = 0.0;
+    int32 code;
+    dxfdouble val;
+    for (int i = 0; i < count; i++) {
+      if (!in.readGroupCode(code) || !in.readDouble(val)) return false;
+      sum += val;
+    }
+    t = now() - t;
+    if (t < best_new) best_new = t;
+    sum_new = sum;
+  }
+  printf("%d values: atof %.1f ns/value, dimeInput %.1f ns/value%s\n",
+	 count, best_old * 1e9 / count, best_new * 1e9 / count,
+	 sum_old == sum_new ? "" : " (results differ!)");
+  return true;
+}
+
+//
+// Times reading all records of the file, without storing them, and
+// reading it into a dimeModel.
+//
+
+static bool
+bench_file(const char *filename, const char *name, const int flags,
+	   const int runs)
+{
+  double best_records = 1e30, best_model = 1e30;
+  bool binary = false;
+  for (int run = 0; run < runs; run++) {
+    dimeInput in;
+    if (!in.setFile(filename, flags)) {
+      fprintf(stderr, "Error opening file for reading: %s\n", filename);
+      return false;
+    }
+    double t = now();
+    int32 code;
+    dimeParam param;
+    while (in.readGroupCode(code)) {
+      if (!dimeRecord::readRecordData(&in, code, param)) break;
+    }
+    t = now() - t;
+    if (t < best_records) best_records = t;
+    binary = in.isBinary();
+
+    dimeInput in2;
+    if (!in2.setFile(filename, flags)) return false;
+    dimeModel model(true);
+    t = now();
+    bool ok = model.read(&in2);
+    t = now() - t;
+    if (!ok) {
+      fprintf(stderr, "Error reading %s\n", filename);
+      return false;
+    }
+    if (t < best_model) best_model = t;
+  }
+  printf("%s (%s): records %.3f s, model %.3f s\n", name,
+	 binary ? "binary" : "ascii", best_records, best_model);
+  return true;
+}
+
+//
+// Writes the file as binary DXF to outname.
+//
+
+static bool
+write_binary(const char *filename, const char *outname)
+{
+  dimeInput in;
+  dimeModel model;
+  if (!in.setFile(filename) || !model.read(&in)) {
+    fprintf(stderr, "Error reading %s\n", filename);
+    return false;
+  }
+  dimeOutput out;
+  out.setBinary(true);
+  if (!out.setFilename(outname) || !model.write(&out)) {
+    fprintf(stderr, "Error writing %s\n", outname);
+    return false;
+  }
+  return true;
+}
+
+int
+main(int argc, char **argv)
+{
+  int runs = 5;
+  int count = 2000000;
+  int flags = 0;
+  bool binary = false;
+  dimeArray <const char*> files;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if (argv[i][0] != '-' || argv[i][1] == 0) {
+      files.append(argv[i]);
+    }
+    else {
+      switch (argv[i][1]) {
+      case 'n':
+	i++;
+	if (i >= argc || (runs = atoi(argv[i])) < 1) return usage(argv[0]);
+	break;
+      case 'c':
+	i++;
+	if (i >= argc || (count = atoi(argv[i])) < 0) return usage(argv[0]);
+	break;
+      case 'b':
+	binary = true;
+	break;
+      case 'm':
+#ifdef DIME_INPUT_MMAP
+	flags |= DIME_INPUT_MMAP;
+#endif
+	break;
+      default:
+	return usage(argv[0]);
+      }
+    }
+  }
+  if (count == 0 && files.count() == 0) return usage(argv[0]);
+
+  bool ok = true;
+  if (count > 0) ok = bench_numbers(count, runs);
+  for (i = 0; i < files.count() && ok; i++) {
+    ok = bench_file(files[i], files[i], flags, runs);
+    if (ok && binary) {
+      static const char binname[] = "dxfbench.dxb";
+      ok = write_binary(files[i], binname) &&
+	bench_file(binname, files[i], flags, runs);
+      remove(binname);
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -87,6 +87,8 @@ typedef long int32;
 typedef signed int int32;
 #endif // ! defined(_WIN32)
 typedef unsigned int uint32;
+typedef signed long long int64;
+typedef unsigned long long uint64;
 #endif // ! defined(__BEOS__)
 
 #ifdef macintosh
@@ -97,7 +99,8 @@ typedef unsigned int uint32;
 memh ? (type*) memh->allocMem((num)*sizeof(type)) : new type[num]
 
 #define DXF_STRCPY(mh, d, s) \
-mh ? d = mh->stringAlloc(s) : d = new char[strlen(s)+1]; if (d) strcpy(d,s)
+do { if (mh) d = (mh)->stringAlloc(s); \
+     else { d = new char[strlen(s)+1]; strcpy(d,s); } } while (0)
 
 typedef bool dimeCallbackFunc(const class dimeState * const, class dimeEntity *, void *);
 typedef dimeCallbackFunc * dimeCallback;
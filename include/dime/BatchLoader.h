@@ -0,0 +1,96 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef DIME_BATCHLOADER_H
+#define DIME_BATCHLOADER_H
+
+#include <dime/Basic.h>
+#include <dime/util/Array.h>
+#include <atomic>
+
+class dimeModel;
+class dimeReadOptions;
+struct dimeBatchFile;
+
+// called from a worker thread for each file read without errors
+typedef bool dimeBatchCallback(const char *filename, dimeModel *model,
+                               void *userdata);
+
+class DIME_DLL_API dimeBatchLoader
+{
+public:
+  dimeBatchLoader();
+  ~dimeBatchLoader();
+
+  void addFile(const char * const filename,
+               const char * const outfilename = NULL);
+  int getNumFiles() const;
+  void clear();
+
+  void setNumThreads(const int numthreads);
+  int getNumThreads() const;
+  void setInputFlags(const int flags);
+  void setReadOptions(const dimeReadOptions * const options);
+  void setUseMemHandler(const bool onoff);
+  void setBinaryOutput(const bool onoff);
+  void setCallback(dimeBatchCallback *callback, void *userdata);
+
+  int run();
+
+  const char *getFilename(const int idx) const;
+  bool isLoaded(const int idx) const;
+  const char *getError(const int idx) const;
+  uint64 getFileSize(const int idx) const;
+  double getLoadTime(const int idx) const;
+
+  int getNumFailed() const;
+  uint64 getTotalBytes() const;
+  double getElapsedTime() const;
+
+private:
+  void loadFile(dimeBatchFile * const file);
+  void worker();
+
+  dimeArray <dimeBatchFile*> files;
+  int numThreads;
+  int inputFlags;
+  const dimeReadOptions *options;
+  bool useMemHandler;
+  bool binaryOutput;
+  dimeBatchCallback *callback;
+  void *callbackData;
+  std::atomic<int> nextFile;     // next file taken by a worker
+  double elapsed;
+
+}; // class dimeBatchLoader
+
+#endif // ! DIME_BATCHLOADER_H
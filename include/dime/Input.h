@@ -38,18 +38,27 @@
 
 #define DXF_MAXLINELEN 4096
 
+// flags for dimeInput::setFile() and dimeInput::setFilePointer()
+#define DIME_INPUT_MMAP 0x0001 // map the file into memory instead of reading it
+#define DIME_INPUT_READAHEAD 0x0002 // read the file on a helper thread
+
 class DIME_DLL_API dimeInput
 {
 public:
   dimeInput();
   ~dimeInput();
   
-  bool setFileHandle(FILE *fp);
-  bool setFile(const char * const filename);
-  bool setFilePointer(const int fd);
+  bool setFileHandle(FILE *fp, const int flags = 0);
+  bool setFile(const char * const filename, const int flags = 0);
+  bool setFilePointer(const int fd, const int flags = 0);
+  bool setBuffer(const void * const data, const size_t len,
+                 const bool copy = false);
   bool eof() const;
   void setCallback(int (*cb)(float, void *), void *cbdata);
+  void setProgressGranularity(const size_t bytes);
   float relativePosition();
+  void setNumThreads(const int numthreads);
+  int getNumThreads() const;
 
   void putBackGroupCode(const int32 code);
   bool readGroupCode(int32 &code);
@@ -64,7 +73,7 @@ public:
   class dimeModel *getModel();
   class dimeMemHandler *getMemHandler();
     
-  int getFilePosition() const;
+  int64 getFilePosition() const;
   
   bool isBinary() const;
   int getVersion() const;
@@ -72,26 +81,47 @@ public:
   
 private:
   friend class dimeModel;
+  friend class dimeEntity;
+  friend class dimeEntityStream;
+  friend class dimePushParser;
+  friend class dimeEntitiesSection;
+  friend class dimeReadAhead;
+  friend class dimeRecordHolder;
+  friend class dimeRecord;
+  template <int encoding> friend class dimeReader;
   dimeModel *model;              // set by the dimeModel class.
-  int filePosition;
+  dimeInput *parent;             // set when reading a part of another input
+  class dimeMemHandler *memhandler; // overrides the model's memory handler
+  const class dimeReadOptions *options; // set by dimeModel::read()
+  bool skipChildren;             // skip VERTEX, ATTRIB and SEQEND entities
+  int numThreads;
+  int64 filePosition;
   bool binary;
   bool binary16bit;
+  const struct dimeInputReader *reader; // set by checkBinary()
   int version;
 
   int fd;
-#ifdef USE_GZFILE
-  void *gzfp; // gzip file pointer
-  bool gzeof;
-#else // ! USE_GZFILE
+  class dimeReadAhead *readAhead;
+  class dimeInflater *inflater;  // set when the file is compressed
   FILE *fp;
   bool fpeof;
-#endif // ! USE_GZFILE
-  long filesize;
+  int64 filesize;
   char *readbuf;
+  char *filebuf;
+  char *mapaddr;
+  bool ownsMap;
+  bool mapIsBuffer;              // mapaddr is memory, not a mapped file
+  bool mapRetained;              // another input keeps the mapping
+  size_t mapsize;
+  size_t mapoffset;
+  uint64 bufferOffset;           // file offset of readbuf when not mapped
   int readbufIndex;
   int readbufLen;
   
   dimeArray <char> backBuf;
+  dimeArray <class dimeRecord*> recordBuf; // see dimeRecordHolder::read()
+  dimeArray <char> packBuf;
   int backBufIndex; 
 
   char lineBuf[DXF_MAXLINELEN];
@@ -100,7 +130,8 @@ private:
   int (*callback)(float, void*);
   void *callbackdata;
   float prevposition;
-  int cbcnt;
+  size_t cbGranularity;
+  uint64 cbNext;                 // offset of the next progress report
   bool aborted;
   bool prevwashandle;
   bool didOpenFile;
@@ -108,21 +139,42 @@ private:
 
 private:
   bool init();
+  bool mapFile(const int fd);
+  void unmapFile();
   bool doBufferRead();
+  uint64 readOffset() const;
+  bool reportProgress();
+  int readData(char * const buf, const int size);
+  int readFile(char * const buf, const int size);
+  bool checkCompressed();
+  void startReadAhead(const int flags);
   void putBack(const char c);
-  void putBack(const char * const string);
   bool get(char &c);
-  bool read(char &c);
-  bool skipWhiteSpace();
-  bool nextLine();
+  bool readBytes(void *data, const int n);
+  bool fillBuffer();
+  bool readLine(const char *&line, int &len);
+  bool readLineSlow(const char *&line, int &len);
+  const char *storeString(const char *str, int len,
+                          const bool terminated = false);
   bool readInteger(long &l);
-  bool readUnsignedInteger(unsigned long &l);
-  bool readUnsignedIntegerString(char * const str);
-  int readDigits(char * const string);
-  int readHexDigits(char * const string);
-  int readChar(char * const string, char charToRead);
   bool readReal(dxfdouble &d);
   bool checkBinary();
+  bool readRecordData(const int groupcode, dimeParam &param);
+
+  // used by dimeEntity::readEntitiesParallel()
+  bool canSplit() const;
+  size_t tell() const;
+  bool initPart(dimeInput * const parent, const size_t offset,
+                const int64 position, dimeMemHandler * const memhandler);
+  bool retainMapping(dimeInput * const input);
+
+  // used to skip data not wanted according to the read options
+  bool skipValue(const int32 groupcode);
+  bool skipRecords();
+  bool skipSection();
+  int peekLayer(char * const layername, const int maxlen);
+  int peekLayerAscii(char * const layername, const int maxlen) const;
+  int peekLayerBinary(char * const layername, const int maxlen) const;
 }; // class dimeInput
 
 #endif // ! DIME_INPUT_H
@@ -76,9 +76,6 @@ private:
   int16 colorNum;
   int16 flags;
 
-  static void cleanup_default_layer(void);
-  static dimeLayer * defaultLayer;
-
 }; // class dimeLayer
 
 inline const char *
@@ -39,6 +39,8 @@
 #include <dime/Base.h>
 #include <dime/Layer.h>
 #include <stdlib.h>
+#include <mutex>
+#include <atomic>
 
 class dimeInput;
 class dimeOutput;
@@ -50,6 +52,7 @@ class dimeBlocksSection;
 class dimeBlock;
 class dimeEntity;
 class dimeRecord;
+class dimeReadOptions;
 
 class DIME_DLL_API dimeModel
 {
@@ -60,7 +63,8 @@ public:
   dimeModel *copy() const;
 
   bool init();
-  bool read(dimeInput * const in);
+  bool read(dimeInput * const in,
+            const dimeReadOptions * const options = NULL);
   bool write(dimeOutput * const out);
 
   int countRecords() const;
@@ -99,21 +103,24 @@ public:
   void insertSection(dimeSection * const section, const int idx = -1);
   void removeSection(const int idx);
 
-  void registerHandle(const int handle);
+  void registerHandle(const uint64 handle);
   void registerHandle(const char * const handle);
-  int getUniqueHandle();
+  uint64 getUniqueHandle();
   const char *getUniqueHandle(char *buf, const int bufsize);
   void addEntity(dimeEntity *entity);
 
 private:
   class dimeDict *refDict;
+  mutable std::mutex refMutex; // entities may be read in parallel
   class dimeDict *layerDict;
+  std::atomic<const dimeLayer*> lastLayer; // see addLayer()
   class dimeMemHandler *memoryHandler;
+  class dimeInput *pinnedInput;  // keeps the strings borrowed when read
   dimeArray <class dimeSection*> sections;
   dimeArray <class dimeLayer*> layers;
   dimeArray <dimeRecord*> headerComments;
 
-  int largestHandle;
+  uint64 largestHandle;
   bool usememhandler;
 }; // class dimeModel
 
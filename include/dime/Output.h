@@ -51,7 +51,7 @@ public:
   void setBinary(const bool state = true);
   bool isBinary() const;
 
-  bool writeHeader() {return true;}
+  bool writeHeader();
   bool writeGroupCode(const int groupcode);
   bool writeInt8(const int8 val);
   bool writeInt16(const int16 val);
@@ -60,6 +60,7 @@ public:
   bool writeDouble(const dxfdouble val);
   bool writeString(const char * const str);
   bool writeString(const wchar_t * const str);	// PWH.
+  bool flush();
 
   int getUniqueHandleId();
 
@@ -67,8 +68,14 @@ private:
   friend class dimeModel;
   dimeModel *model;
   FILE *fp;
+  int fd;
   bool binary;
 
+  char *buffer;
+  int bufferPos;
+  bool failed;
+  int recordType; // of the last group code, for binary output
+
   int (*callback)(float, void*);
   void *callbackdata;
   int numrecords;
@@ -76,6 +83,14 @@ private:
   bool aborted;
   bool didOpenFile;
 
+  char *reserve(const int size);
+  bool writeData(const char * const data, const size_t size);
+  void putString(const char * const str, const char terminator);
+  void putBinaryInteger(const int32 val);
+  void putBinaryDouble(const dxfdouble val);
+  void putBinaryString(const char * const str);
+  void setFp(FILE * const fp, const bool didopen);
+
 }; // class dimeOutput
 
 #endif // ! DIME_OUTPUT_H
@@ -0,0 +1,120 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef DIME_PUSHPARSER_H
+#define DIME_PUSHPARSER_H
+
+#include <dime/Basic.h>
+#include <dime/Input.h>
+#include <dime/Model.h>
+
+class dimeEntity;
+class dimeMemHandler;
+
+// called for each entity in the BLOCKS and ENTITIES sections
+typedef bool dimePushEntityCallback(const char *section, dimeEntity *entity,
+                                    void *userdata);
+// called at the beginning and at the end of each section
+typedef bool dimePushSectionCallback(const char *section, bool begin,
+                                     void *userdata);
+
+class DIME_DLL_API dimePushParser
+{
+public:
+  dimePushParser();
+  ~dimePushParser();
+
+  void setEntityCallback(dimePushEntityCallback *callback, void *userdata);
+  void setSectionCallback(dimePushSectionCallback *callback, void *userdata);
+
+  bool feed(const char * const data, const size_t len);
+  bool finish();
+  void reset();
+
+  bool isDone() const;
+  bool hasError() const;
+  bool isAborted() const;
+  bool isBinary() const;
+  const char *getSectionName() const;
+  int64 getFilePosition() const;
+
+  dimeModel *getModel();
+  const dimeModel *getModel() const;
+
+private:
+  bool parse();
+  bool checkEncoding(const bool final);
+  int nextRecord(int32 &code, const char *&value, int &len,
+                 size_t &codeend);
+  int nextRecordAscii(int32 &code, const char *&value, int &len,
+                      size_t &codeend);
+  int nextRecordBinary(int32 &code, const char *&value, int &len,
+                       size_t &codeend);
+  bool handleRecord(const int32 code, const char * const value,
+                    const int len, const size_t start,
+                    const size_t codeend);
+  bool readUnit(const size_t end);
+  bool readEntity();
+  bool readSection();
+  void recycle();
+  void compact();
+
+  dimeModel model;
+  dimeInput input;               // reads the units from the buffer
+  dimeMemHandler *memhandler;
+  dimeEntity *entity;
+  dimePushEntityCallback *entityCallback;
+  void *entityData;
+  dimePushSectionCallback *sectionCallback;
+  void *sectionData;
+
+  char *buffer;                  // the unit being read, and unread data
+  size_t bufferSize;
+  size_t bufferLen;
+  size_t scanPos;                // start of the next record
+  size_t unitStart;              // start of the current unit, or 0
+  int64 unitPosition;            // file position of the current unit
+  bool unitIsBlock;              // the unit is a BLOCK without ENDBLK
+  int64 position;                // file position of the next record
+  int64 recordPosition;          // file position of the last record
+
+  int state;
+  bool binary;
+  bool binary16bit;
+  char header[22];               // the sentinel of binary files
+  char section[32];
+  bool error;
+  bool aborted;
+
+}; // class dimePushParser
+
+#endif // ! DIME_PUSHPARSER_H
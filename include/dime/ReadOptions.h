@@ -0,0 +1,76 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef DIME_READOPTIONS_H
+#define DIME_READOPTIONS_H
+
+#include <dime/Basic.h>
+
+class dimeDict;
+
+class DIME_DLL_API dimeReadOptions
+{
+public:
+  dimeReadOptions();
+  ~dimeReadOptions();
+
+  void keepSection(const char * const sectionname);
+  void keepEntity(const char * const entityname);
+  void keepLayer(const char * const layername);
+
+  bool isSectionKept(const char * const sectionname) const;
+  bool isEntityKept(const char * const entityname) const;
+  bool isLayerKept(const char * const layername) const;
+
+  bool filtersEntities() const;
+  bool filtersLayers() const;
+
+  void setLazyEntities(const bool onoff);
+  bool getLazyEntities() const;
+
+  void setPackedRecords(const bool onoff);
+  bool getPackedRecords() const;
+
+  void setBorrowStrings(const bool onoff);
+  bool getBorrowStrings() const;
+
+private:
+  dimeDict *sections;
+  dimeDict *entities;
+  dimeDict *layers;
+  bool lazyEntities;
+  bool packedRecords;
+  bool borrowStrings;
+
+}; // class dimeReadOptions
+
+#endif // ! DIME_READOPTIONS_H
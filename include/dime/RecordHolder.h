@@ -34,11 +34,40 @@
 #define DIME_RECORDHOLDER_H
 
 #include <dime/Base.h>
+#include <type_traits>
 
 class dimeInput;
 class dimeMemHandler;
 class dimeOutput;
 class dimeRecord;
+class dimeRecordHolder;
+
+// A member which is read directly from the file, without going through
+// handleRecord(). See dimeRecordHolder::getFields().
+struct dimeRecordField
+{
+  int16 groupcode;
+  int16 type; // record type of the group code, and type of the member
+  void *(*member)(dimeRecordHolder * const holder);
+};
+
+template <class T> struct dimeRecordFieldType;
+template <> struct dimeRecordFieldType<dxfdouble>
+{ enum { value = dimeBase::dimeDoubleRecordType }; };
+template <> struct dimeRecordFieldType<int16>
+{ enum { value = dimeBase::dimeInt16RecordType }; };
+template <> struct dimeRecordFieldType<int32>
+{ enum { value = dimeBase::dimeInt32RecordType }; };
+
+// Makes a dimeRecordField for \a member of \a classname. Must be used
+// in the definition of a static member of \a classname, since the member
+// is usually not public.
+#define DIME_RECORD_FIELD(groupcode, classname, member) \
+  { groupcode, \
+    dimeRecordFieldType<std::remove_reference< \
+      decltype(((classname*) 0)->member)>::type>::value, \
+    [](dimeRecordHolder * const holder) -> void * \
+    { return &static_cast<classname*>(holder)->member; } }
 
 class DIME_DLL_API dimeRecordHolder : public dimeBase
 {
@@ -75,6 +104,7 @@ protected:
   virtual bool handleRecord(const int groupcode,
 			    const dimeParam &param,
 			    dimeMemHandler * const memhandler);
+  virtual const dimeRecordField *getFields() const;
   
   bool copyRecords(dimeRecordHolder * const rh, 
 		   dimeMemHandler * const memhandler) const;
@@ -87,8 +117,13 @@ protected:
   // int separator; // not needed ?
 
 private:
+  char *packedRecords; // see dimeReadOptions::setPackedRecords()
+
   void setRecordCommon(const int groupcode, const dimeParam &param,
                        const int index, dimeMemHandler * const memhandler);
+  template <int encoding> bool readRecords(dimeInput * const in);
+  template <int encoding> bool readPacked(dimeInput * const in);
+  void unpackRecords();
 
 }; // class dimeRecordHolder
 
@@ -1,9 +1,13 @@
 ﻿// PWH.
 #pragma once
 
+#include <dime/BatchLoader.h>
+#include <dime/EntityStream.h>
 #include <dime/Input.h>
 #include <dime/Output.h>
 #include <dime/Model.h>
+#include <dime/PushParser.h>
+#include <dime/ReadOptions.h>
 #include <dime/RecordHolder.h>
 
 #include <dime/convert/convert.h>
@@ -76,6 +76,7 @@ protected:
   virtual bool handleRecord(const int groupcode,
 			    const dimeParam &param, 
 			    dimeMemHandler * const memhandler);
+  virtual const dimeRecordField *getFields() const;
   
   int16 flags; 
 
@@ -84,6 +85,9 @@ public:
 #ifndef NO_RR_DATA
   class dimeBlock *block; // ugly, needed for RR
 #endif
+private:
+  static const dimeRecordField fields[];
+
 }; // class dime3DFace
 
 #endif // ! DIME_3DFACE_H
@@ -72,8 +72,10 @@ protected:
   virtual bool handleRecord(const int groupcode, 
 			    const dimeParam &param,
                             dimeMemHandler * const memhandler);
+  virtual const dimeRecordField *getFields() const;
     
 private:
+  static const dimeRecordField fields[];
   dimeVec3f center;
   dxfdouble radius;
   dxfdouble startAngle;
@@ -48,6 +48,8 @@ class DIME_DLL_API dimeBlock : public dimeEntity
   friend class dimeEntitiesSection;
   friend class dimeInsert;
   friend class dimeModel;
+  friend class dimeEntityStream;
+  friend class dimePushParser;
   
 public:
   dimeBlock(dimeMemHandler * const memhandler);
@@ -74,11 +76,13 @@ public:
   virtual bool write(dimeOutput * const out);
   virtual int typeId() const;
   virtual int countRecords() const;
+  virtual void releaseMemory();
 
 protected:  
   virtual bool handleRecord(const int groupcode, 
                             const dimeParam & param,
 			    dimeMemHandler * const memhandler);
+  virtual const dimeRecordField *getFields() const;
   
   virtual void fixReferences(dimeModel * const model);
   virtual bool traverse(const dimeState * const state, 
@@ -86,6 +90,7 @@ protected:
                         void *userdata);
   
 private:
+  static const dimeRecordField fields[];
   int16 flags;
   const char *name;
   dimeVec3f basePoint;
@@ -56,6 +56,11 @@
 
 class dimeLayer;
 class dimeModel;
+class dimeEntity;
+
+// creates an entity, see dimeEntity::registerEntity()
+typedef dimeEntity *dimeEntityFactory(const char * const name,
+                                      dimeMemHandler * const memhandler);
 
 class DIME_DLL_API dimeEntity : public dimeRecordHolder
 {
@@ -87,6 +92,7 @@ public:
   virtual bool isOfType(const int thetypeid) const;
   virtual int countRecords() const;
   virtual void print() const {}
+  virtual void releaseMemory();
   
   
   bool isDeleted() const;
@@ -127,9 +133,14 @@ protected:
 public:
   static dimeEntity *createEntity(const char * const name,
 				 dimeMemHandler * const memhandler = NULL);
+  static void registerEntity(const char * const name,
+                             dimeEntityFactory * const factory);
   static bool readEntities(dimeInput * const file, 
 			   dimeArray <dimeEntity*> &array, 
 			   const char * const stopat);
+  static bool readEntitiesParallel(dimeInput * const file,
+                                   dimeArray <dimeEntity*> &array,
+                                   const char * const boundary = NULL);
   
   static bool copyEntityArray(const dimeEntity *const*const array, 
 			      const int nument,
@@ -146,6 +157,17 @@ protected:
   bool copyRecords(dimeEntity * const entity, dimeModel * const model) const;
 
 private:
+  static bool scanEntities(dimeInput * const file,
+                           const char * const boundary,
+                           dimeArray <size_t> &starts,
+                           dimeArray <size_t> &ends,
+                           dimeArray <int64> &positions,
+                           class dimeDict * const namedict = NULL,
+                           dimeArray <const char*> * const names = NULL,
+                           dimeArray <const dimeLayer*> * const layers = NULL);
+  static bool skipEntity(dimeInput * const file, const char * const name,
+                         const bool inblock, bool &checklayer);
+
   const dimeLayer *layer;
   int16 entityFlags;
   int16 colorNumber;
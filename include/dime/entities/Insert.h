@@ -85,11 +85,13 @@ protected:
   virtual bool handleRecord(const int groupcode, 
 			    const dimeParam &param,
 			    dimeMemHandler * const memhandler);
+  virtual const dimeRecordField *getFields() const;
   virtual bool traverse(const dimeState * const state, 
                         dimeCallback callback,
                         void *userdata);
 
 private:
+  static const dimeRecordField fields[];
   void makeMatrix(dimeMatrix &m) const;
 
   int16 attributesFollow;
@@ -58,7 +58,8 @@ public:
   int32 getHJust() const;
   void setVJust(const int32 v);
   int32 getVJust() const;
-  void setTextString(const char* s);
+  void setTextString(const char* s,
+                     dimeMemHandler * const memhandler = NULL);
 
   //<< PWH.
   dxfdouble getWScale() const { return wScale; }
@@ -310,6 +311,11 @@ public:
 	virtual bool write(dimeOutput * const out);
 	virtual int typeId() const;
 	virtual int countRecords() const;
+	virtual void releaseMemory() {
+		// the strings are not in the memory handler
+		std::string().swap(strText);
+		std::string().swap(strTextStyleName);
+	}
 
 	virtual GeometryType extractGeometry(dimeArray <dimeVec3f> &verts,
 		dimeArray <int> &indices,
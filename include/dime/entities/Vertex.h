@@ -82,8 +82,10 @@ protected:
   virtual bool handleRecord(const int groupcode, 
 			    const dimeParam &param,
                             dimeMemHandler * const memhandler);
+  virtual const dimeRecordField *getFields() const;
   
 private:
+  static const dimeRecordField fields[];
   int16 flags;
 #ifdef DIME_FIXBIG
   int32 indices[4];
@@ -65,6 +65,8 @@ public:
 public:
   static bool readRecordData(dimeInput * const in, const int group_code,
 			     dimeParam &param);
+  static bool writeRecordData(dimeOutput * const out, const int group_code,
+                              const dimeParam &param);
   static dimeRecord *readRecord(dimeInput * const in);
   static dimeRecord *createRecord(const int group_code, 
 				 dimeMemHandler * const memhandler);
@@ -35,6 +35,11 @@
 
 #include <dime/sections/Section.h>
 #include <dime/util/Array.h>
+#include <stddef.h>
+
+class dimeInput;
+class dimeLayer;
+class dimeDict;
 
 class DIME_DLL_API dimeEntitiesSection : public dimeSection
 {
@@ -56,12 +61,28 @@ public:
 
   int getNumEntities() const;
   dimeEntity *getEntity(const int idx);
+  const char *getEntityName(const int idx) const;
+  const dimeLayer *getEntityLayer(const int idx) const;
   void removeEntity(const int idx);
   void insertEntity(dimeEntity * const entity, const int idx = -1); 
   
 private:
+  bool readLazy(dimeInput * const file, dimeInput * const input);
+  dimeEntity *decodeEntity(const int idx);
+  void decodeAll();
+
   dimeArray <dimeEntity*> entities;
 
+  // for entities not decoded yet, see readLazy()
+  dimeInput *source;
+  dimeInput *decoder;
+  dimeDict *nameDict;
+  dimeArray <size_t> offsets;
+  dimeArray <int64> positions;
+  dimeArray <const char*> names;
+  dimeArray <const dimeLayer*> layers;
+  int numLazy;
+
 }; // class dimeEntitiesSection
 
 #endif // ! DIME_ENTITIESSECTION_H
@@ -39,6 +39,11 @@
 class dimeInput;
 class dimeModel;
 class dimeOutput;
+class dimeSection;
+
+// creates a section, see dimeSection::registerSection()
+typedef dimeSection *dimeSectionFactory(const char * const sectionname,
+                                        dimeMemHandler * const memhandler);
 
 class DIME_DLL_API dimeSection : public dimeBase
 {
@@ -58,6 +63,8 @@ public:
 public:
   static dimeSection *createSection(const char * const sectionname,
 				   dimeMemHandler *memhandler);
+  static void registerSection(const char * const sectionname,
+                              dimeSectionFactory * const factory);
 
 protected:
   dimeMemHandler *memHandler;
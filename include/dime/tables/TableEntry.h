@@ -37,6 +37,11 @@
 #include <dime/RecordHolder.h>
 
 class dimeModel;
+class dimeTableEntry;
+
+// creates a table entry, see dimeTableEntry::registerTableEntry()
+typedef dimeTableEntry *dimeTableEntryFactory(const char * const name,
+                                              dimeMemHandler * const memhandler);
 
 class DIME_DLL_API dimeTableEntry : public dimeRecordHolder
 {
@@ -57,6 +62,8 @@ public:
 
   static dimeTableEntry *createTableEntry(const char * const name,
 					 dimeMemHandler * const memhandler = NULL);
+  static void registerTableEntry(const char * const name,
+                                 dimeTableEntryFactory * const factory);
   
 protected:
   bool preWrite(dimeOutput * const output);
@@ -42,9 +42,8 @@ class DIME_DLL_API dimeDictEntry
 
 private:
   dimeDictEntry *next;
-  dimeDictEntry(const char * const k, void *v) {key = strdup(k); value = v; };
-  ~dimeDictEntry() {free(key);} 
-  char *key;
+  unsigned int hash;
+  char *key;                     // stored right after the entry
   void *value;
 
 }; // class dimeDictEntry
@@ -66,8 +65,12 @@ public:
 private:
   int tableSize;
   dimeDictEntry **buckets;
-  dimeDictEntry *&findEntry(const char * const key) const;
-  unsigned int bucketNr(const char *key) const;
+  class dimeMemHandler *memhandler; // holds the entries and the keys
+  dimeDictEntry *&findEntry(const char * const key,
+                            unsigned int &hash) const;
+  dimeDictEntry *newEntry(const char * const key, const unsigned int hash,
+                          void *value);
+  static unsigned int hashKey(const char *key);
 
 public:
   void print_info();
@@ -45,11 +45,20 @@ public:
 
   char *stringAlloc(const char * const string);
   void *allocMem(const int size, const int alignment = 4);
+  void adopt(dimeMemHandler * const handler);
+  void reset();
+
+  void borrowStrings(const void * const data, const size_t size);
+  void borrowStrings(const dimeMemHandler * const handler);
   
 private:
 
   class dimeMemNode *bigmemnode; // linked list of big memory chunks 
   class dimeMemNode *memnode;   // linked list of memory nodes.
+  dimeMemHandler *adopted;      // linked list of adopted handlers
+  dimeMemHandler *nextAdopted;
+  const char *borrowBegin;      // strings in here are not copied
+  const char *borrowEnd;
 
 }; // class dimeMemHandler
 
@@ -0,0 +1,161 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+
+#ifndef DIME_REGISTRY_H
+#define DIME_REGISTRY_H
+
+#include <dime/Basic.h>
+#include <string.h>
+
+//
+// A table of factory functions keyed by name, used to create entities,
+// sections and table entries from the names in the file. The table is
+// an open addressing hash table which stores the hash of each name, so
+// a lookup normally needs a single string compare. Names are never
+// removed, but their factory can be set to NULL.
+//
+
+template <class T>
+class dimeRegistry
+{
+public:
+  dimeRegistry();
+  ~dimeRegistry();
+
+  void enter(const char * const name, T factory);
+  T find(const char * const name) const;
+
+  static unsigned int hash(const char *name);
+
+private:
+  struct Entry {
+    unsigned int hash;
+    char *name;
+    T factory;
+  };
+  Entry *table;
+  int size;   // always a power of two
+  int count;
+
+  void grow();
+  int findSlot(const char * const name, const unsigned int h) const;
+}; // class dimeRegistry
+
+template <class T> inline
+dimeRegistry<T>::dimeRegistry()
+  : size( 64 ), count( 0 )
+{
+  this->table = new Entry[this->size];
+  memset(this->table, 0, this->size * sizeof(Entry));
+}
+
+template <class T> inline
+dimeRegistry<T>::~dimeRegistry()
+{
+  for (int i = 0; i < this->size; i++) free(this->table[i].name);
+  delete [] this->table;
+}
+
+// FNV-1a
+template <class T> inline unsigned int
+dimeRegistry<T>::hash(const char *name)
+{
+  unsigned int h = 2166136261u;
+  while (*name) {
+    h ^= (unsigned char) *name++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// returns the slot of name, or the empty slot where it belongs
+template <class T> inline int
+dimeRegistry<T>::findSlot(const char * const name, const unsigned int h) const
+{
+  int mask = this->size - 1;
+  int i = (int) (h & mask);
+  while (this->table[i].name) {
+    if (this->table[i].hash == h && !strcmp(this->table[i].name, name))
+      break;
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+template <class T> inline void
+dimeRegistry<T>::grow()
+{
+  Entry *old = this->table;
+  int oldsize = this->size;
+  this->size *= 2;
+  this->table = new Entry[this->size];
+  memset(this->table, 0, this->size * sizeof(Entry));
+  for (int i = 0; i < oldsize; i++) {
+    if (old[i].name)
+      this->table[this->findSlot(old[i].name, old[i].hash)] = old[i];
+  }
+  delete [] old;
+}
+
+/*!
+  Sets the factory for \a name, replacing any previous factory.
+*/
+
+template <class T> inline void
+dimeRegistry<T>::enter(const char * const name, T factory)
+{
+  unsigned int h = hash(name);
+  int i = this->findSlot(name, h);
+  if (!this->table[i].name) {
+    if (2 * (this->count + 1) > this->size) {
+      this->grow();
+      i = this->findSlot(name, h);
+    }
+    this->table[i].hash = h;
+    this->table[i].name = strdup(name);
+    this->count++;
+  }
+  this->table[i].factory = factory;
+}
+
+/*!
+  Returns the factory for \a name, or NULL if there is none.
+*/
+
+template <class T> inline T
+dimeRegistry<T>::find(const char * const name) const
+{
+  return this->table[this->findSlot(name, hash(name))].factory;
+}
+
+#endif // ! DIME_REGISTRY_H
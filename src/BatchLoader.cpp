@@ -0,0 +1,479 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class dimeBatchLoader dime/BatchLoader.h
+  \brief The dimeBatchLoader class reads many DXF files concurrently.
+
+  Files are added with addFile(), and read by run() on a pool of
+  worker threads, see setNumThreads(). Each file is read into its own
+  dimeInput and dimeModel, optionally with its own dimeMemHandler,
+  which are destructed before the worker takes the next file. Only
+  the number of threads set limits how many files are in memory at
+  once.
+
+  A file that can not be read does not stop the other files. The
+  result of each file is available from isLoaded() and getError()
+  when run() returns, together with the size of the file and the time
+  spent on it. getTotalBytes() and getElapsedTime() give the aggregate
+  throughput.
+
+  Each model read is passed to the callback set with setCallback(),
+  and is written to a DXF file when an output file name was given to
+  addFile(). The callback is called from the worker threads, and
+  must be thread safe.
+
+  Typical usage:
+
+  \code
+  dimeBatchLoader loader;
+  for (int i = 1; i < argc; i++) loader.addFile(argv[i]);
+  loader.setCallback(process_model, &mydata);
+  if (loader.run() > 0) {
+    for (int i = 0; i < loader.getNumFiles(); i++) {
+      if (!loader.isLoaded(i))
+        fprintf(stderr, "%s: %s\n", loader.getFilename(i),
+                loader.getError(i));
+    }
+  }
+  \endcode
+
+  Files are read in parallel without locking, which is safe because
+  the state shared between models is either constant or initialized
+  once in a thread safe way: the record type table, the default layer
+  and the entity, section and table entry registries. Register custom
+  factories (dimeEntity::registerEntity() etc) before run() is
+  called, and do not modify the dimeReadOptions while it runs.
+  Diagnostics written by the library go to \e stderr one line at a
+  time, and lines from different files may be interleaved. Use
+  getError() to find which files failed.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h> // first, it may enable large file support
+#endif // HAVE_CONFIG_H
+
+#include <dime/BatchLoader.h>
+#include <dime/Input.h>
+#include <dime/Output.h>
+#include <dime/Model.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <stdio.h>
+#include <new>
+#include <thread>
+#include <chrono>
+
+#define ERRORLEN 128
+
+struct dimeBatchFile {
+  char *filename;
+  char *outfilename;
+  bool loaded;
+  char error[ERRORLEN];
+  uint64 size;
+  double time;
+};
+
+static char *
+dime_copy_string(const char * const str)
+{
+  if (str == NULL) return NULL;
+  char *copy = new char[strlen(str)+1];
+  strcpy(copy, str);
+  return copy;
+}
+
+static double
+dime_seconds_since(const std::chrono::steady_clock::time_point &start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+/*!
+  Constructor.
+*/
+
+dimeBatchLoader::dimeBatchLoader()
+  : numThreads( 1 ), inputFlags( 0 ), options( NULL ),
+    useMemHandler( true ), binaryOutput( false ), callback( NULL ),
+    callbackData( NULL ), nextFile( 0 ), elapsed( 0.0 )
+{
+  this->setNumThreads(0);
+}
+
+/*!
+  Destructor.
+*/
+
+dimeBatchLoader::~dimeBatchLoader()
+{
+  this->clear();
+}
+
+/*!
+  Adds \a filename to the files read by run(). If \a outfilename is
+  not \e NULL, the model is written to this file after it has been
+  read.
+*/
+
+void
+dimeBatchLoader::addFile(const char * const filename,
+                         const char * const outfilename)
+{
+  dimeBatchFile *file = new dimeBatchFile;
+  file->filename = dime_copy_string(filename);
+  file->outfilename = dime_copy_string(outfilename);
+  file->loaded = false;
+  file->error[0] = 0;
+  file->size = 0;
+  file->time = 0.0;
+  this->files.append(file);
+}
+
+/*!
+  Returns the number of files added.
+*/
+
+int
+dimeBatchLoader::getNumFiles() const
+{
+  return this->files.count();
+}
+
+/*!
+  Removes all files and their results.
+*/
+
+void
+dimeBatchLoader::clear()
+{
+  for (int i = 0; i < this->files.count(); i++) {
+    delete [] this->files[i]->filename;
+    delete [] this->files[i]->outfilename;
+    delete this->files[i];
+  }
+  this->files.setCount(0);
+  this->elapsed = 0.0;
+}
+
+/*!
+  Sets the number of files read at the same time. If \a numthreads
+  is 0 or less, the number of hardware threads is used, which is the
+  default.
+*/
+
+void
+dimeBatchLoader::setNumThreads(const int numthreads)
+{
+  int n = numthreads;
+  if (n <= 0) n = (int) std::thread::hardware_concurrency();
+  this->numThreads = n > 0 ? n : 1;
+}
+
+/*!
+  Returns the number of files read at the same time.
+  \sa setNumThreads()
+*/
+
+int
+dimeBatchLoader::getNumThreads() const
+{
+  return this->numThreads;
+}
+
+/*!
+  Sets the flags passed to dimeInput::setFile() for each file.
+  Default is 0.
+*/
+
+void
+dimeBatchLoader::setInputFlags(const int flags)
+{
+  this->inputFlags = flags;
+}
+
+/*!
+  Sets the options passed to dimeModel::read() for each file. The
+  options are shared by all workers and must not be changed or
+  destructed before run() returns.
+*/
+
+void
+dimeBatchLoader::setReadOptions(const dimeReadOptions * const options)
+{
+  this->options = options;
+}
+
+/*!
+  Sets whether each model should allocate its entities and records
+  with a dimeMemHandler. Default is \e true, which is faster and frees
+  a model in one go.
+*/
+
+void
+dimeBatchLoader::setUseMemHandler(const bool onoff)
+{
+  this->useMemHandler = onoff;
+}
+
+/*!
+  Sets whether output files are written as binary DXF. Default is
+  \e false.
+*/
+
+void
+dimeBatchLoader::setBinaryOutput(const bool onoff)
+{
+  this->binaryOutput = onoff;
+}
+
+/*!
+  Sets a callback called with each model read. \a userdata is passed
+  as the last argument. If the callback returns \e false, the file is
+  reported as failed and not written.
+*/
+
+void
+dimeBatchLoader::setCallback(dimeBatchCallback *callback, void *userdata)
+{
+  this->callback = callback;
+  this->callbackData = userdata;
+}
+
+/*!
+  Reads all files added, using at most getNumThreads() threads, and
+  returns the number of files that failed.
+*/
+
+int
+dimeBatchLoader::run()
+{
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  int n = this->files.count();
+  int numthreads = this->numThreads < n ? this->numThreads : n;
+  this->nextFile = 0;
+
+  // the calling thread works too
+  std::thread *threads = numthreads > 1 ?
+    new std::thread[numthreads-1] : NULL;
+  for (int i = 0; i < numthreads-1; i++) {
+    threads[i] = std::thread(&dimeBatchLoader::worker, this);
+  }
+  this->worker();
+  for (int i = 0; i < numthreads-1; i++) threads[i].join();
+  delete [] threads;
+
+  this->elapsed = dime_seconds_since(start);
+  return this->getNumFailed();
+}
+
+/*!
+  Returns the name of file number \a idx.
+*/
+
+const char *
+dimeBatchLoader::getFilename(const int idx) const
+{
+  assert(idx >= 0 && idx < this->files.count());
+  return this->files[idx]->filename;
+}
+
+/*!
+  Returns \e true if file number \a idx was read (and written)
+  without errors by the last call to run().
+*/
+
+bool
+dimeBatchLoader::isLoaded(const int idx) const
+{
+  assert(idx >= 0 && idx < this->files.count());
+  return this->files[idx]->loaded;
+}
+
+/*!
+  Returns why file number \a idx failed, or an empty string if it
+  did not.
+*/
+
+const char *
+dimeBatchLoader::getError(const int idx) const
+{
+  assert(idx >= 0 && idx < this->files.count());
+  return this->files[idx]->error;
+}
+
+/*!
+  Returns the size in bytes of file number \a idx, as found by
+  run().
+*/
+
+uint64
+dimeBatchLoader::getFileSize(const int idx) const
+{
+  assert(idx >= 0 && idx < this->files.count());
+  return this->files[idx]->size;
+}
+
+/*!
+  Returns the number of seconds spent on file number \a idx, including
+  the callback and writing the output file.
+*/
+
+double
+dimeBatchLoader::getLoadTime(const int idx) const
+{
+  assert(idx >= 0 && idx < this->files.count());
+  return this->files[idx]->time;
+}
+
+/*!
+  Returns the number of files that failed in the last call to run().
+*/
+
+int
+dimeBatchLoader::getNumFailed() const
+{
+  int cnt = 0;
+  for (int i = 0; i < this->files.count(); i++) {
+    if (!this->files[i]->loaded) cnt++;
+  }
+  return cnt;
+}
+
+/*!
+  Returns the sum of the sizes of all files.
+*/
+
+uint64
+dimeBatchLoader::getTotalBytes() const
+{
+  uint64 sum = 0;
+  for (int i = 0; i < this->files.count(); i++) {
+    sum += this->files[i]->size;
+  }
+  return sum;
+}
+
+/*!
+  Returns the wall clock time in seconds of the last call to run().
+*/
+
+double
+dimeBatchLoader::getElapsedTime() const
+{
+  return this->elapsed;
+}
+
+//
+// takes files until there are none left
+//
+
+void
+dimeBatchLoader::worker()
+{
+  int n = this->files.count();
+  int idx;
+  while ((idx = this->nextFile++) < n) {
+    dimeBatchFile *file = this->files[idx];
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    file->loaded = false;
+    file->error[0] = 0;
+    // a failing allocation must not end the other files
+    try {
+      this->loadFile(file);
+    }
+    catch (const std::bad_alloc &) {
+      file->loaded = false;
+      snprintf(file->error, ERRORLEN, "out of memory");
+    }
+    catch (...) {
+      file->loaded = false;
+      snprintf(file->error, ERRORLEN, "unexpected exception");
+    }
+    file->time = dime_seconds_since(start);
+  }
+}
+
+//
+// reads one file, and writes it if an output file was given
+//
+
+void
+dimeBatchLoader::loadFile(dimeBatchFile * const file)
+{
+#ifdef _WIN32
+  struct _stat64 st; // stat() fails on files over 2 GB
+  if (_stat64(file->filename, &st) == 0) file->size = (uint64) st.st_size;
+#else // ! _WIN32
+  struct stat st;
+  if (stat(file->filename, &st) == 0) file->size = (uint64) st.st_size;
+#endif // ! _WIN32
+
+  dimeInput in;
+  if (!in.setFile(file->filename, this->inputFlags)) {
+    snprintf(file->error, ERRORLEN, "unable to open file");
+    return;
+  }
+  dimeModel model(this->useMemHandler);
+  if (!model.read(&in, this->options)) {
+    if (in.isAborted()) snprintf(file->error, ERRORLEN, "read aborted");
+    else snprintf(file->error, ERRORLEN, "read error at line %lld",
+                  (long long) in.getFilePosition());
+    return;
+  }
+  if (this->callback &&
+      !this->callback(file->filename, &model, this->callbackData)) {
+    snprintf(file->error, ERRORLEN, "rejected by callback");
+    return;
+  }
+  if (file->outfilename) {
+    dimeOutput out;
+    if (!out.setFilename(file->outfilename)) {
+      snprintf(file->error, ERRORLEN, "unable to open output file: %s",
+               file->outfilename);
+      return;
+    }
+    out.setBinary(this->binaryOutput);
+    if (!model.write(&out)) {
+      snprintf(file->error, ERRORLEN, "write error");
+      return;
+    }
+  }
+  file->loaded = true;
+}
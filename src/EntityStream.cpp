@@ -0,0 +1,303 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class dimeEntityStream dime/EntityStream.h
+  \brief The dimeEntityStream class reads the entities of a DXF file
+  one at a time.
+
+  Unlike dimeModel::read(), which keeps every entity in memory, this
+  class returns the entities in the BLOCKS and ENTITIES sections one
+  by one, and frees each entity when the next one is requested. The
+  memory used is therefore independent of the number of entities in
+  the file, which makes it suitable for files too large to be kept
+  in memory.
+
+  The other sections (HEADER, CLASSES, TABLES, OBJECTS, ...) are read
+  into an internal dimeModel, available from getModel(). Since the
+  sections in front of the first BLOCKS or ENTITIES section are read
+  by open(), the header variables, tables and layers are available
+  before the first entity is returned. Layers not found in the
+  TABLES section are added to the model as the entities using them
+  are read.
+
+  Blocks are returned as dimeBlock entities, including the entities
+  in the block, and freed like any other entity. Hence, INSERT
+  entities are not connected to their blocks, and
+  dimeInsert::getBlock() will return \e NULL. Use
+  dimeInsert::getBlockName() instead, and copy the blocks you need
+  while they are available.
+
+  Typical usage:
+
+  \code
+  dimeInput in;
+  if (!in.setFile(filename)) return false;
+  dimeEntityStream stream;
+  if (!stream.open(&in)) return false;
+  dimeEntity *entity;
+  while ((entity = stream.next()) != NULL) {
+    // do something with the entity
+  }
+  if (stream.hasError()) return false;
+  \endcode
+*/
+
+#include <dime/EntityStream.h>
+#include <dime/Input.h>
+#include <dime/entities/Entity.h>
+#include <dime/entities/Block.h>
+#include <dime/sections/Section.h>
+#include <dime/util/MemHandler.h>
+
+#include <string.h>
+
+/*!
+  Constructor.
+*/
+
+dimeEntityStream::dimeEntityStream()
+  : model( false ), input( NULL ), entity( NULL ), section( NULL ),
+    error( false )
+{
+  this->memhandler = new dimeMemHandler;
+}
+
+/*!
+  Destructor. Frees the last entity returned from next().
+*/
+
+dimeEntityStream::~dimeEntityStream()
+{
+  this->recycle();
+  delete this->memhandler;
+}
+
+/*!
+  Prepares for reading entities from \a in, and reads all sections in
+  front of the first BLOCKS or ENTITIES section into the model. Returns
+  \e false if the sections could not be read. \a in must not be
+  destructed before the stream is done.
+*/
+
+bool
+dimeEntityStream::open(dimeInput * const in)
+{
+  this->recycle();
+  this->model.init();
+  in->model = &this->model; // _very_ important
+  this->input = in;
+  this->section = NULL;
+  this->error = false;
+  return this->readSections() || !this->error;
+}
+
+/*!
+  Returns the next entity in the BLOCKS or ENTITIES sections, or \e
+  NULL when there are no more entities, or if an error occurred. The
+  entity is owned by the stream, and is freed by the next call to this
+  method. Any sections following the last BLOCKS or ENTITIES section
+  are read into the model before \e NULL is returned.
+
+  \sa hasError()
+*/
+
+dimeEntity *
+dimeEntityStream::next()
+{
+  this->recycle();
+
+  int32 groupcode;
+  const char *string;
+  while (this->input) {
+    if (this->section == NULL) {
+      if (!this->readSections()) break;
+      continue;
+    }
+    if (!this->input->readGroupCode(groupcode) || groupcode != 0 ||
+        (string = this->input->readString()) == NULL) {
+      fprintf(stderr,"Error reading groupcode: %d\n", groupcode);
+      this->error = true;
+      break;
+    }
+    if (!strcmp(string, "ENDSEC")) {
+      this->section = NULL;
+      continue;
+    }
+    dimeMemHandler *prev = this->input->memhandler;
+    this->input->memhandler = this->memhandler;
+    this->entity = dimeEntity::createEntity(string, this->memhandler);
+    bool ok = this->entity != NULL && this->entity->read(this->input);
+    this->input->memhandler = prev;
+    if (!ok) {
+      fprintf(stderr,"error reading entity at line: %lld.\n",
+              (long long) this->input->getFilePosition());
+      this->error = true;
+      break;
+    }
+    return this->entity;
+  }
+  this->input = NULL;
+  return NULL;
+}
+
+/*!
+  Returns the name of the section of the last entity returned from
+  next(), i.e. "BLOCKS" or "ENTITIES".
+*/
+
+const char *
+dimeEntityStream::getSectionName() const
+{
+  return this->section;
+}
+
+/*!
+  Returns \e true if an error occurred while reading the file.
+*/
+
+bool
+dimeEntityStream::hasError() const
+{
+  return this->error;
+}
+
+/*!
+  Returns the model containing all sections read so far, except the
+  BLOCKS and ENTITIES sections. Layers, handles and block names found
+  in the entities are registered here too.
+*/
+
+dimeModel *
+dimeEntityStream::getModel()
+{
+  return &this->model;
+}
+
+/*!
+  \overload
+*/
+
+const dimeModel *
+dimeEntityStream::getModel() const
+{
+  return &this->model;
+}
+
+//
+// Reads sections into the model until the start of a BLOCKS or
+// ENTITIES section, which will be streamed. Returns \e false at the
+// end of the file, or on errors.
+//
+
+bool
+dimeEntityStream::readSections()
+{
+  dimeInput *in = this->input;
+  int32 groupcode;
+  const char *string;
+  bool ok;
+
+  while (true) {
+    ok = false;
+    if (!in->readGroupCode(groupcode)) break;
+    if (groupcode != 0 && groupcode != 999) break;
+    string = in->readString();
+    if (string == NULL) break;
+
+    if (groupcode == 999) continue; // comments are not kept
+    if (!strcmp(string, "SECTION")) {
+      ok = in->readGroupCode(groupcode);
+      string = in->readString();
+      ok = ok && string != NULL && groupcode == 2;
+      if (!ok) break;
+      if (!strcmp(string, "BLOCKS")) {
+        this->section = "BLOCKS";
+        return true;
+      }
+      if (!strcmp(string, "ENTITIES")) {
+        this->section = "ENTITIES";
+        return true;
+      }
+      dimeSection *sect =
+        dimeSection::createSection(string, in->getMemHandler());
+      ok = sect != NULL && sect->read(in);
+      if (!ok) {
+        delete sect;
+        break;
+      }
+      this->model.insertSection(sect);
+    }
+    else if (!strcmp(string, "EOF")) {
+      this->input = NULL;
+      return false;
+    }
+    else break; // something unexpected has happened
+  }
+  if (in->isAborted()) {
+#ifndef NDEBUG
+    fprintf(stderr,"DXF read aborted by user.\n");
+#endif
+  }
+  else {
+#ifndef NDEBUG
+    fprintf(stderr, "DXF loading failed at line: %lld\n",
+            (long long) in->getFilePosition());
+#endif
+  }
+  this->error = true;
+  this->input = NULL;
+  return false;
+}
+
+//
+// Frees the last entity returned from next(). Blocks are removed from
+// the model's dictionary, so that INSERT entities will not be
+// connected to freed blocks.
+//
+
+void
+dimeEntityStream::recycle()
+{
+  if (this->entity) {
+    if (this->entity->typeId() == dimeBase::dimeBlockType) {
+      dimeBlock *block = (dimeBlock*)this->entity;
+      if (block->name) this->model.addReference(block->name, NULL);
+    }
+    // destructors are not called for entities allocated by a memory
+    // handler. releaseMemory() frees what the entity holds outside of
+    // the memory handler, and the rest is freed by reset()
+    this->entity->releaseMemory();
+    this->entity = NULL;
+    this->memhandler->reset();
+  }
+}
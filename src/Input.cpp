@@ -35,47 +35,382 @@
   \brief The dimeInput class offers transparent file I/O for DXF and DXB
 */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h> // first, it may enable large file support
+#endif // HAVE_CONFIG_H
+
 #ifdef _WIN32
 #include <io.h>
+#include <windows.h>
 #else
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <fcntl.h>
 #include <float.h>
+#include <math.h>
 #include <stdio.h>
+#include <limits.h>
+#include <charconv>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #ifdef macintosh
 #include "unix.h"
 #endif
 
-#ifdef USE_GZFILE
+#ifdef HAVE_ZLIB
 #include <zlib.h>
-#endif
+#endif // HAVE_ZLIB
 
 #include <dime/Input.h>
 #include <dime/Model.h>
+#include <dime/records/Record.h>
+#include "InputReader.h"
 
 #define READBUFSIZE 65536
 
-#define TMPBUFSIZE 512 // temporary buffer used to read floats or integers
+// mapped files are handed to the tokenizer in windows of this size, to
+// keep the buffer indices within the range of an int
+#define MAPWINDOWSIZE (1 << 30)
+
+#define READAHEADBUFS 4 // number of buffers filled by the read-ahead thread
+
+#ifdef _WIN32
+// off_t and struct stat are 32 bit on Windows, also in 64 bit builds
+typedef struct _stat64 dime_stat_t;
+#define DIME_FSTAT(fd, st) _fstat64(fd, st)
+#define DIME_LSEEK(fd, offset, whence) _lseeki64(fd, offset, whence)
+#else // ! _WIN32
+// off_t is 64 bit with _FILE_OFFSET_BITS=64, see CMakeLists.txt
+typedef struct stat dime_stat_t;
+#define DIME_FSTAT(fd, st) fstat(fd, st)
+#define DIME_LSEEK(fd, offset, whence) lseek(fd, offset, whence)
+#endif // ! _WIN32
+
+//
+// Returns the value strtod() returns for a number outside the range
+// of a double, by finding the decimal exponent of the first
+// significant digit.
+//
+static double
+dime_outofrange(const char *str, const char *end)
+{
+  bool negative = *str == '-';
+  if (negative) str++;
+  long mag = 0;
+  while (str < end && *str == '0') str++;
+  if (str < end && *str == '.') {
+    str++;
+    while (str < end && *str == '0') { str++; mag--; }
+  }
+  else {
+    while (str < end && isdigit((unsigned char) *str)) { str++; mag++; }
+  }
+  while (str < end && *str != 'e' && *str != 'E') str++;
+  if (str < end) {
+    str++;
+    bool negexp = *str == '-';
+    if (*str == '-' || *str == '+') str++;
+    long exp;
+    if (std::from_chars(str, end, exp).ec != std::errc()) exp = LONG_MAX / 2;
+    mag += negexp ? -exp : exp;
+  }
+  double val = mag > 0 ? HUGE_VAL : 0.0;
+  return negative ? -val : val;
+}
+
+//
+// Reads a file on a helper thread into a ring of buffers, which the
+// parser empties through read(). The parser then only waits for the
+// file when the helper thread can't keep up, and decompression of
+// compressed files runs in parallel with the parsing.
+//
+
+class dimeReadAhead
+{
+public:
+  dimeReadAhead(dimeInput * const input);
+  ~dimeReadAhead();
+
+  int read(char * const buf, const int size);
+
+private:
+  void run();
+
+  dimeInput *input; // only readFile() is called from the helper thread
+  char *buffers[READAHEADBUFS];
+  int lengths[READAHEADBUFS];
+  int head;   // next buffer to fill
+  int tail;   // buffer being read
+  int filled; // number of buffers filled and not read
+  int readpos;
+  bool done;
+  bool stop;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::thread thread;
+}; // class dimeReadAhead
+
+dimeReadAhead::dimeReadAhead(dimeInput * const input)
+  : input( input ), head( 0 ), tail( 0 ), filled( 0 ), readpos( 0 ),
+    done( false ), stop( false )
+{
+  for (int i = 0; i < READAHEADBUFS; i++) {
+    this->buffers[i] = new char[READBUFSIZE];
+    this->lengths[i] = 0;
+  }
+  this->thread = std::thread(&dimeReadAhead::run, this);
+}
+
+dimeReadAhead::~dimeReadAhead()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->cond.notify_all();
+  this->thread.join(); // waits for a blocking read to return
+  for (int i = 0; i < READAHEADBUFS; i++) delete [] this->buffers[i];
+}
+
+//
+// Copies up to size bytes to buf, waiting for the helper thread if
+// necessary. Like fread(), less than size bytes are only returned at
+// the end of the file.
+//
+
+int
+dimeReadAhead::read(char * const buf, const int size)
+{
+  int n = 0;
+  while (n < size) {
+    if (this->readpos == 0) {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cond.wait(lock, [this] { return this->filled > 0 || this->done; });
+      if (this->filled == 0) break; // end of file
+    }
+    // the buffer at tail is left alone by the helper thread until released
+    int len = this->lengths[this->tail] - this->readpos;
+    if (len > size - n) len = size - n;
+    memcpy(buf + n, this->buffers[this->tail] + this->readpos, len);
+    this->readpos += len;
+    n += len;
+    if (this->readpos == this->lengths[this->tail]) {
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->tail = (this->tail + 1) % READAHEADBUFS;
+        this->filled--;
+        this->readpos = 0;
+      }
+      this->cond.notify_all();
+    }
+  }
+  return n;
+}
+
+//
+// The helper thread. Fills buffers as long as there are free ones.
+//
+
+void
+dimeReadAhead::run()
+{
+  while (true) {
+    int idx;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cond.wait(lock, [this] { 
+        return this->filled < READAHEADBUFS || this->stop; });
+      if (this->stop) break;
+      idx = this->head;
+    }
+    int len = this->input->readFile(this->buffers[idx], READBUFSIZE);
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (len > 0) {
+        this->lengths[idx] = len;
+        this->head = (this->head + 1) % READAHEADBUFS;
+        this->filled++;
+      }
+      else this->done = true;
+    }
+    this->cond.notify_all();
+    if (len <= 0) break;
+  }
+}
+
+//
+// Decompresses a gzip or zlib stream read from a file, through an
+// input buffer of a fixed size. Concatenated gzip members are read
+// as one stream, like gzip -d does.
+//
+
+class dimeInflater
+{
+public:
+  dimeInflater(FILE * const fp, const char * const data, const int len);
+  ~dimeInflater();
+
+  bool isValid() const { return this->valid; }
+  int read(char * const buf, const int size);
+  int64 getPosition() const { return this->position; }
+
+  static bool isCompressed(const char * const data, const size_t len);
+
+private:
+  FILE *fp;
+  char *inbuf;
+  bool valid;
+  bool done;
+  std::atomic<int64> position; // compressed bytes read
+#ifdef HAVE_ZLIB
+  z_stream stream;
+#endif // HAVE_ZLIB
+}; // class dimeInflater
+
+//
+// Starts decompressing. The first len bytes of the stream are in
+// data, the rest is read from fp.
+//
+
+dimeInflater::dimeInflater(FILE * const fp, const char * const data,
+                           const int len)
+  : fp( fp ), inbuf( NULL ), valid( false ), done( false ), position( 0 )
+{
+#ifdef HAVE_ZLIB
+  this->inbuf = new char[READBUFSIZE];
+  memcpy(this->inbuf, data, len);
+  memset(&this->stream, 0, sizeof(this->stream));
+  this->stream.next_in = (Bytef*) this->inbuf;
+  this->stream.avail_in = len;
+  // 32 enables automatic detection of the gzip or zlib header
+  this->valid = inflateInit2(&this->stream, 15 + 32) == Z_OK;
+#else // ! HAVE_ZLIB
+  fprintf(stderr, "Compressed input is not supported "
+          "(dime was built without zlib).\n");
+#endif // ! HAVE_ZLIB
+}
+
+dimeInflater::~dimeInflater()
+{
+#ifdef HAVE_ZLIB
+  if (this->valid) inflateEnd(&this->stream);
+#endif // HAVE_ZLIB
+  delete [] this->inbuf;
+}
+
+//
+// Returns true if data starts with a gzip or zlib header. Takes the
+// full length of the data, since a file may be larger than an int.
+//
+
+bool
+dimeInflater::isCompressed(const char * const data, const size_t len)
+{
+  if (len < 2) return false;
+  unsigned char b0 = (unsigned char) data[0];
+  unsigned char b1 = (unsigned char) data[1];
+  if (b0 == 0x1f && b1 == 0x8b) return true; // gzip
+  // zlib: deflate method, and a header checksum which ASCII text
+  // starting with 'x' is unlikely to match
+  return (b0 & 0x0f) == 8 && (b0 >> 4) <= 7 && ((b0 << 8) | b1) % 31 == 0;
+}
+
+//
+// Decompresses up to size bytes into buf. Like fread(), less than
+// size bytes are only returned at the end of the stream, or when the
+// stream is corrupt.
+//
+
+int
+dimeInflater::read(char * const buf, const int size)
+{
+#ifdef HAVE_ZLIB
+  if (!this->valid) return 0;
+  this->stream.next_out = (Bytef*) buf;
+  this->stream.avail_out = size;
+  while (this->stream.avail_out > 0 && !this->done) {
+    if (this->stream.avail_in == 0) {
+      int len = (int) fread(this->inbuf, 1, READBUFSIZE, this->fp);
+      if (len <= 0) {
+        fprintf(stderr, "Unexpected end of compressed file.\n");
+        this->done = true;
+        break;
+      }
+      this->position += len;
+      this->stream.next_in = (Bytef*) this->inbuf;
+      this->stream.avail_in = len;
+    }
+    int ret = inflate(&this->stream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) {
+      // look for another gzip member
+      if (this->stream.avail_in == 0) {
+        int len = (int) fread(this->inbuf, 1, READBUFSIZE, this->fp);
+        if (len > 0) this->position += len;
+        this->stream.next_in = (Bytef*) this->inbuf;
+        this->stream.avail_in = len > 0 ? len : 0;
+      }
+      if (this->stream.avail_in == 0 ||
+          !isCompressed((const char*) this->stream.next_in,
+                        this->stream.avail_in)) this->done = true;
+      else inflateReset(&this->stream);
+    }
+    else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      fprintf(stderr, "Error in compressed file: %s\n",
+              this->stream.msg ? this->stream.msg : "unknown error");
+      this->done = true;
+    }
+  }
+  return size - (int) this->stream.avail_out;
+#else // ! HAVE_ZLIB
+  return 0;
+#endif // ! HAVE_ZLIB
+}
+
+#define DIME_READER(encoding) {                 \
+    encoding,                                   \
+    dimeReader<encoding>::readGroupCode,        \
+    dimeReader<encoding>::readInt8,             \
+    dimeReader<encoding>::readInt16,            \
+    dimeReader<encoding>::readInt32,            \
+    dimeReader<encoding>::readFloat,            \
+    dimeReader<encoding>::readDouble,           \
+    dimeReader<encoding>::readString,           \
+    dimeReader<encoding>::readStringNoSkip,     \
+    dimeReader<encoding>::readRecordData }
+
+// indexed by the DIME_ENCODING_* values
+static const dimeInputReader dime_readers[] = {
+  DIME_READER(DIME_ENCODING_ASCII),
+  DIME_READER(DIME_ENCODING_BINARY),
+  DIME_READER(DIME_ENCODING_SWAPPED)
+};
+
+#undef DIME_READER
 
 /*!
   Constructor.
 */
 
 dimeInput::dimeInput()
-  : model( NULL ), version( 12 ), fd( -1 ), readbuf( NULL ),
-    callback( NULL ), callbackdata( NULL )
+  : model( NULL ), parent( NULL ), memhandler( NULL ), options( NULL ),
+    skipChildren( false ), numThreads( 1 ),
+    version( 12 ), fd( -1 ), readAhead( NULL ), inflater( NULL ),
+    fp( NULL ), readbuf( NULL ),
+    filebuf( NULL ), mapaddr( NULL ), ownsMap( false ),
+    mapIsBuffer( false ), mapRetained( false ), mapsize( 0 ),
+    mapoffset( 0 ), bufferOffset( 0 ),
+    callback( NULL ), callbackdata( NULL ), cbGranularity( 0 )
 {
-#ifdef USE_GZFILE
-  this->gzfp = NULL;
-#else
-  this->fp = NULL;
   this->didOpenFile = false;
-#endif
   this->prevwashandle = false;
 }
 
@@ -85,12 +420,11 @@ dimeInput::dimeInput()
 
 dimeInput::~dimeInput()
 {
-  delete [] this->readbuf;
-#ifdef USE_GZFILE
-  if (this->gzfp) gzclose(this->gzfp);
-#else
+  delete this->readAhead; // stop reading before the file is closed
+  this->unmapFile();
+  delete [] this->filebuf;
+  delete this->inflater;
   if (this->fp && this->didOpenFile) fclose(this->fp);
-#endif
 }
 
 bool
@@ -102,30 +436,33 @@ dimeInput::init()
   this->filePosition = 0;
   this->binary = false;
   this->binary16bit = false;
+  this->reader = &dime_readers[DIME_ENCODING_ASCII];
 
   this->fd = -1;
-#ifdef USE_GZFILE
-  if (this->gzfp) gzclose(this->gzfp);
-  this->gzfp = NULL;
-  this->gzeof = true;
-#else
+  delete this->readAhead;
+  this->readAhead = NULL;
+  delete this->inflater;
+  this->inflater = NULL;
   if (this->fp && this->didOpenFile) fclose(this->fp);
   this->fp = NULL;
   this->didOpenFile = false;
   this->fpeof = true;
-#endif
   this->filesize = 0;
-  if (this->readbuf == NULL) {
-    this->readbuf = new char[READBUFSIZE]; // create buffer
-    if (!this->readbuf) return false;
+  this->unmapFile();
+  if (this->filebuf == NULL) {
+    this->filebuf = new char[READBUFSIZE]; // create buffer
+    if (!this->filebuf) return false;
   }
+  this->readbuf = this->filebuf;
   this->readbufIndex = 0;
   this->readbufLen = 0;
   this->backBufIndex = -1;
   this->backBuf.setCount(0);
   this->prevposition = 0.0f;
-  this->cbcnt = 0;
+  this->cbNext = 0;
+  this->bufferOffset = 0;
   this->prevwashandle = false;
+  this->skipChildren = false;
   this->endianSwap = false;
   return true;
 }
@@ -143,6 +480,7 @@ dimeInput::isAborted() const
 /*!
   This method sets a progress callback that will be called with a
   float in the range between 0 and 1, and void * \a cbdata as arguments.
+  See setProgressGranularity() for how often it is called.
 */
 
 void 
@@ -151,30 +489,94 @@ dimeInput::setCallback(int (*cb)(float, void *), void *cbdata)
   this->callback = cb;
   this->callbackdata = cbdata;
   this->prevposition = 0.0f;
-  this->cbcnt = 0;
+  this->cbNext = 0;
+}
+
+/*!
+  Sets the progress callback to be called each time another \a bytes
+  bytes of the file have been read. The default, 0, calls it for each
+  percent of the file.
+*/
+
+void
+dimeInput::setProgressGranularity(const size_t bytes)
+{
+  this->cbGranularity = bytes;
+  this->cbNext = 0;
 }
 
 /*!
   Returns the relative file position. 0.0 means beginning of file,
-  1.0 is at end of file.
+  1.0 is at end of file. For compressed files the position in the
+  compressed data is used. 0.0 is returned when the size of the
+  file is unknown, as for pipes.
 */
 
 float
 dimeInput::relativePosition()
 {
-  assert(this->didOpenFile);
-  if (!this->filesize) return 0.0f;
-  return (((float)(lseek(this->fd, 0, SEEK_CUR)-(readbufLen-readbufIndex)))/
-	  ((float)(this->filesize)));
+  if (this->filesize <= 0) return 0.0f;
+  if (this->inflater) {
+    // only the position in the compressed file is known
+    return (float) ((double) this->inflater->getPosition() /
+                    (double) this->filesize);
+  }
+  return (float) ((double) this->readOffset() / (double) this->filesize);
+}
+
+/*!
+  Sets the number of threads used to read the ENTITIES and BLOCKS
+  sections. The sections are split into parts at entity boundaries,
+  and the parts are read in parallel. Use 0 to get one thread per
+  processor core. The default is 1, which reads everything in
+  sequence.
+
+  Parallel reading is only done for memory mapped input, see
+  DIME_INPUT_MMAP. Other inputs are read in sequence.
+*/
+
+void 
+dimeInput::setNumThreads(const int numthreads)
+{
+  int n = numthreads;
+  if (n <= 0) n = (int) std::thread::hardware_concurrency();
+  this->numThreads = n > 0 ? n : 1;
+}
+
+/*!
+  Returns the number of threads used to read the file.
+  \sa setNumThreads()
+*/
+
+int 
+dimeInput::getNumThreads() const
+{
+  return this->numThreads;
 }
 
 /*!
   Opens the file \a filename for reading. True is returned if the file
   is opened correctly. File will be closed in destructor.
+
+  If \a flags contains DIME_INPUT_MMAP, the file is mapped into memory
+  and parsed directly from the mapping, which avoids copying the file
+  through an intermediate read buffer. Files that cannot be mapped
+  (pipes, devices) are read the normal way.
+
+  If \a flags contains DIME_INPUT_READAHEAD, and the file is not
+  mapped into memory, the file is read on a helper thread a few
+  buffers ahead of the parser, so that reading (and decompression,
+  of compressed files) overlaps with the parsing. This is
+  useful for pipes and slow devices.
+
+  Files compressed with gzip (or zlib) are detected from the first
+  bytes of the file, and are decompressed while they are read. This
+  requires that dime is built with zlib. Compressed files are never
+  memory mapped.
 */
 
 bool
-dimeInput::setFile(const char * const filename)
+dimeInput::setFile(const char * const filename, const int flags)
 {
 #ifdef _WIN32
   int fd = open(filename, O_RDONLY | O_BINARY);
@@ -184,22 +586,27 @@ dimeInput::setFile(const char * const filename)
   if (fd < 0) {
     return false;
   }
-  return setFilePointer(fd);
+  return setFilePointer(fd, flags);
 }
 
 /*!
   Sets the input data to the stream \a fp. \a fp must be a valid file/stream,
-  and will \e not be closed in the destructor. No progress information
-  will be available during loading if this method is used.
+  and will \e not be closed in the destructor. Progress information
+  is only available when \a fp is a regular file. Only the
+  DIME_INPUT_READAHEAD flag is supported, see setFile().
 */
 bool 
-dimeInput::setFileHandle(FILE *fp)
+dimeInput::setFileHandle(FILE *fp, const int flags)
 {
   if (!this->init()) return false;
   this->fp = fp;
   this->fpeof = false;
   this->didOpenFile = false;
-  this->filesize = 1;
+  dime_stat_t st;
+  if (DIME_FSTAT(fileno(fp), &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG)
+    this->filesize = (int64) st.st_size;
+  if (!this->checkCompressed()) return false;
+  this->startReadAhead(flags);
   
   this->binary = this->checkBinary();
 
@@ -209,31 +616,83 @@ dimeInput::setFileHandle(FILE *fp)
 
 /*!
   Sets the file pointer for this instance. \a newfd is a file opened 
-  with the unistd open() function.
+  with the unistd open() function. See setFile() for the supported
+  \a flags.
 */
 
 bool 
-dimeInput::setFilePointer(const int newfd)
+dimeInput::setFilePointer(const int newfd, const int flags)
 {
   if (!this->init()) return false;
+  if ((flags & DIME_INPUT_MMAP) && this->mapFile(newfd)) {
+    if (dimeInflater::isCompressed(this->mapaddr, this->mapsize)) {
+      this->unmapFile(); // read and decompress it the normal way
+    }
+    else {
+      // the mapping stays valid after the descriptor is closed
+      close(newfd);
+      this->didOpenFile = true;
+      this->fpeof = false;
+      this->filesize = (int64) this->mapsize;
+      this->binary = this->checkBinary();
+      return true;
+    }
+  }
   this->fd = newfd;
-#if USE_GZFILE
-  this->gzfp = gzdopen(this->fd, "rb");
-  this->gzeof = false; 
-#else
   this->fp = fdopen(this->fd, "rb");
   this->didOpenFile = true;
   this->fpeof = false;
-#endif
-  long startpos = lseek(fd, 0, SEEK_CUR);
-  this->filesize = lseek(fd, 0, SEEK_END);
-  lseek(fd, startpos, SEEK_SET);
+  int64 startpos = DIME_LSEEK(fd, 0, SEEK_CUR);
+  this->filesize = DIME_LSEEK(fd, 0, SEEK_END);
+  DIME_LSEEK(fd, startpos, SEEK_SET);
+  if (!this->checkCompressed()) return false;
+  this->startReadAhead(flags);
 
   this->binary = this->checkBinary();
 
   return this->filesize > 0;
 }
 
+/*!
+  Sets the input data to the \a len bytes at \a data, which can be
+  an ASCII or binary DXF file in memory. If \a copy is false, the
+  data is parsed where it is, and must stay valid until reading is
+  done, or as long as the model when lazy entity decoding is used
+  (see dimeReadOptions::setLazyEntities()). If \a copy is true, the
+  data is copied first.
+
+  The data is read like a memory mapped file, so it can be read in
+  parallel, see setNumThreads(). Compressed data is not supported.
+*/
+
+bool
+dimeInput::setBuffer(const void * const data, const size_t len,
+                     const bool copy)
+{
+  if (!this->init()) return false;
+  if (dimeInflater::isCompressed((const char*) data, len)) {
+    fprintf(stderr, "Compressed data is not supported by "
+            "dimeInput::setBuffer().\n");
+    return false;
+  }
+  if (len == 0) return false;
+  if (copy) {
+    this->mapaddr = new char[len];
+    memcpy(this->mapaddr, data, len);
+  }
+  else this->mapaddr = (char*) data; // never written to
+  this->ownsMap = copy;
+  this->mapIsBuffer = true;
+  this->mapsize = len;
+  this->mapoffset = 0;
+  this->readbuf = this->mapaddr;
+  this->didOpenFile = true;
+  this->fpeof = false;
+  this->filesize = (int64) len;
+  this->binary = this->checkBinary();
+  return true;
+}
+
 /*!
   Returns true if end of file is encountered.
 */
@@ -241,11 +700,7 @@ dimeInput::setFilePointer(const int newfd)
 bool 
 dimeInput::eof() const
 {
-#if USE_GZFILE
-  return this->gzeof;
-#else
   return this->fpeof;
-#endif
 }
 
 /*!
@@ -258,58 +713,7 @@ dimeInput::eof() const
 bool 
 dimeInput::readGroupCode(int32 &code)
 {
-  bool ret;
-  if (this->hasPutBack) {
-    this->hasPutBack = false;
-    code = this->putBackCode;
-    ret = true;
-  }
-  else {
-    if (this->didOpenFile && this->callback && this->cbcnt++ > 100) {
-      this->cbcnt = 0;
-      float pos = this->relativePosition();
-      if (pos > this->prevposition + 0.01f) {
-	this->prevposition = pos;
-	if (!this->callback(pos, this->callbackdata)) {
-	  this->aborted = true;
-	  return false;
-	}
-      }
-    }
-    
-    if (this->binary) {
-      if (this->binary16bit) {
-        uint16 uval;
-        int16 *ptr = (int16*)&uval;
-        ret = this->readInt16(*ptr);
-        code = (int32)uval;
-      }
-      else {
-        unsigned char uval; // group code is unsigned int8
-        char *ptr = (char*) &uval;
-        ret = this->get(*ptr);
-        code = (int32) uval;
-      }
-      if (code == 255) {
-	int16 val16;
-	ret = this->readInt16(val16);
-	code = (int32) val16; 
-      }
-    }
-    else {
-      //
-      // quick fix to ignore comments
-      //
-      ret = readInt32(code);
-      while (ret && code == 999) {
-	readString();
-	ret = readInt32(code);
-      }
-    }
-  }
-  if (code == 5) this->prevwashandle = true;
-  else this->prevwashandle = false;
-  return ret;
+  return this->reader->readGroupCode(this, code);
 }
 
 /*!
@@ -334,18 +738,7 @@ dimeInput::putBackGroupCode(const int32 code)
 bool 
 dimeInput::readInt8(int8 &val)
 {
-  if (this->binary) {
-    char *ptr = (char*)&val;
-    return get(*ptr);
-  }
-  
-  long tmp;
-  bool ok = skipWhiteSpace();
-  if (ok && readInteger(tmp) && tmp >= -128 && tmp <= 127) {
-    val = (int8) tmp;
-    return nextLine();
-  }
-  return false;
+  return this->reader->readInt8(this, val);
 }
 
 /*!
@@ -355,27 +748,7 @@ dimeInput::readInt8(int8 &val)
 bool 
 dimeInput::readInt16(int16 &val)
 {
-  if (this->binary) {
-    bool ret;
-    char *ptr = (char*)&val;
-    if (this->endianSwap) {
-      this->get(ptr[1]);
-      ret = this->get(ptr[0]);
-    }
-    else {
-      this->get(ptr[0]);
-      ret = this->get(ptr[1]);
-    }
-    return ret;
-  }
-
-  long tmp;
-  bool ok = skipWhiteSpace();
-  if (ok && readInteger(tmp) && tmp >= -32768 && tmp <= 32767) {
-    val = (int16) tmp;
-    return nextLine();
-  }
-  return false;
+  return this->reader->readInt16(this, val);
 }
 
 /*!
@@ -385,30 +758,7 @@ dimeInput::readInt16(int16 &val)
 bool 
 dimeInput::readInt32(int32 &val)
 {
-  if (this->binary) {
-    bool ret;
-    char *ptr = (char*)&val;
-    if (this->endianSwap) {
-      this->get(ptr[3]);
-      this->get(ptr[2]);
-      this->get(ptr[1]);
-      ret = this->get(ptr[0]);
-    }
-    else {
-      this->get(ptr[0]);
-      this->get(ptr[1]);
-      this->get(ptr[2]);
-      ret = this->get(ptr[3]);
-    }
-    return ret;
-  }
-  
-  long tmp;
-  if (skipWhiteSpace() && readInteger(tmp)) {
-    val = tmp;
-    return nextLine();
-  }
-  return false;
+  return this->reader->readInt32(this, val);
 }
 
 /*!
@@ -418,35 +768,7 @@ dimeInput::readInt32(int32 &val)
 bool 
 dimeInput::readFloat(float &val)
 {
-  bool ret = false;
-
-  if (this->binary) {
-    // binary files only contains doubles
-    dxfdouble tmp;
-    ret = readDouble(tmp);
-    val = (float) tmp; 
-  }
-  else {
-    dxfdouble tmp;
-    ret = skipWhiteSpace();
-    if (ret && 
-        readReal(tmp)) {    
-      val = (float) tmp;
-      ret = nextLine();
-    }
-  }
-  if (ret) {
-    if (!dime_finite(val)) {
-      int tst = dime_isinf(val);
-      if (tst < 0) {
-        val = -FLT_MAX;
-      }
-      else if (tst > 0) {
-        val = FLT_MAX;
-      }
-    }
-  }
-  return ret;
+  return this->reader->readFloat(this, val);
 }
 
 /*!
@@ -456,55 +778,7 @@ dimeInput::readFloat(float &val)
 bool 
 dimeInput::readDouble(dxfdouble &val)
 {
-  bool ret = false;
-  if (this->binary) {
-    double tmp;
-    assert(sizeof(tmp) == 8);
-    char *ptr = (char*)&tmp;
-    if (this->endianSwap) {
-      this->get(ptr[7]);
-      this->get(ptr[6]);
-      this->get(ptr[5]);
-      this->get(ptr[4]);
-      this->get(ptr[3]);
-      this->get(ptr[2]);
-      this->get(ptr[1]);
-      ret = this->get(ptr[0]);
-      val = (dxfdouble) tmp;
-    }
-    else {
-      this->get(ptr[0]);
-      this->get(ptr[1]);
-      this->get(ptr[2]);
-      this->get(ptr[3]);
-      this->get(ptr[4]);
-      this->get(ptr[5]);
-      this->get(ptr[6]);
-      ret = this->get(ptr[7]);
-      val = (dxfdouble) tmp;
-    }
-  }
-  else {
-    if (skipWhiteSpace()) {
-      if (readReal(val)) {
-        ret = nextLine();
-      }
-    }
-  }
-  
-  if (ret) {
-    if (!dime_finite(val)) {
-      int tst = dime_isinf(val);
-      // choose FLT_MAX as the maximum value if a number is infinite
-      if (tst < 0) {
-        val = -FLT_MAX;
-      }
-      else if (tst > 0) {
-        val = FLT_MAX;
-      }
-    }
-  }
-  return ret;
+  return this->reader->readDouble(this, val);
 }
 
 /*!
@@ -516,33 +790,7 @@ dimeInput::readDouble(dxfdouble &val)
 const char *
 dimeInput::readString()
 {
-  bool ok = skipWhiteSpace();
-  if (ok) {
-    char c;
-    int idx = 0;
-#if 0     
-    if (this->binary) {
-      if (!get(c)) return NULL;
-      if (c != 0) lineBuf[idx++] = c;
-    }
-#endif
-    while (get(c) && c != 0xa && c != 0xd && c != 0 && idx < DXF_MAXLINELEN) {
-      lineBuf[idx++] = c;
-    }
-    if (c == 0xa) this->putBack(c);
-    else if (c == 0xd) this->putBack(c);
-    this->nextLine();
-    this->lineBuf[idx] = '\0';
-
-    if (this->prevwashandle) {
-      this->prevwashandle = false;
-      if (this->model) {
-	this->model->registerHandle(this->lineBuf);
-      }
-    }
-    return this->lineBuf;
-  }
-  return NULL;
+  return this->reader->readString(this);
 }
 
 /*!
@@ -553,29 +801,18 @@ dimeInput::readString()
 const char *
 dimeInput::readStringNoSkip()
 {
-    char c;
-    int idx = 0;
-#if 0     
-    if (this->binary) {
-      if (!get(c)) return NULL;
-      if (c != 0) lineBuf[idx++] = c;
-    }
-#endif
-    while (get(c) && c != 0xa && c != 0xd && c != 0 && idx < DXF_MAXLINELEN) {
-      lineBuf[idx++] = c;
-    }
-    if (c == 0xa) this->putBack(c);
-    else if (c == 0xd) this->putBack(c);
-    this->nextLine();
-    this->lineBuf[idx] = '\0';
-
-    if (this->prevwashandle) {
-      this->prevwashandle = false;
-      if (this->model) {
-	this->model->registerHandle(this->lineBuf);
-      }
-    }
-    return this->lineBuf;
+  return this->reader->readStringNoSkip(this);
+}
+
+//
+// Reads the value of a record with group code \a groupcode, used by
+// dimeRecord::readRecordData().
+//
+
+bool
+dimeInput::readRecordData(const int groupcode, dimeParam &param)
+{
+  return this->reader->readRecordData(this, groupcode, param);
 }
 
 /*!
@@ -585,6 +822,7 @@ dimeInput::readStringNoSkip()
 dimeMemHandler *
 dimeInput::getMemHandler()
 {
+  if (memhandler) return memhandler;
   if (model) return model->getMemHandler();
   return NULL;
 }
@@ -604,7 +842,7 @@ dimeInput::getModel()
   For binary files the file position is returned.
 */
 
-int 
+int64 
 dimeInput::getFilePosition() const
 {
   return filePosition;
@@ -632,6 +870,70 @@ dimeInput::getVersion() const
 
 // private funcs ***********************************************************
 
+//
+// Maps the whole file \a fd into memory. Returns false if the
+// file is not a regular file, or if the mapping failed.
+//
+bool
+dimeInput::mapFile(const int fd)
+{
+  dime_stat_t st;
+  if (DIME_FSTAT(fd, &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG ||
+      st.st_size <= 0 || DIME_LSEEK(fd, 0, SEEK_CUR) != 0)
+    return false;
+  size_t size = (size_t) st.st_size;
+  // too big for the address space of 32 bit processes
+  if ((uint64) size != (uint64) st.st_size) return false;
+#ifdef _WIN32
+  HANDLE mh = CreateFileMapping((HANDLE)_get_osfhandle(fd), NULL,
+                                PAGE_READONLY, 0, 0, NULL);
+  if (mh == NULL) return false;
+  void *addr = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mh);
+  if (addr == NULL) return false;
+#else // ! _WIN32
+  void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+  madvise(addr, size, MADV_SEQUENTIAL);
+#endif // MADV_SEQUENTIAL
+#endif // ! _WIN32
+  this->mapaddr = (char*) addr;
+  this->ownsMap = true;
+  this->mapsize = size;
+  this->mapoffset = 0;
+  this->readbuf = this->mapaddr;
+  return true;
+}
+
+//
+// Releases the memory mapping, if any.
+//
+void
+dimeInput::unmapFile()
+{
+  if (this->mapaddr) {
+    if (this->ownsMap && this->mapIsBuffer) {
+      delete [] this->mapaddr; // copied by setBuffer()
+    }
+    else if (this->ownsMap) {
+#ifdef _WIN32
+      UnmapViewOfFile(this->mapaddr);
+#else // ! _WIN32
+      munmap(this->mapaddr, this->mapsize);
+#endif // ! _WIN32
+    }
+    this->parent = NULL;
+    this->mapaddr = NULL;
+    this->ownsMap = false;
+    this->mapIsBuffer = false;
+    this->mapRetained = false;
+    this->mapsize = 0;
+    this->mapoffset = 0;
+    this->readbuf = this->filebuf;
+  }
+}
+
 //  
 //  Reads a relatively big block from the file into local memory.  
 //  stdio caching is not fast enough...
@@ -639,23 +941,23 @@ dimeInput::getVersion() const
 bool
 dimeInput::doBufferRead()
 {
-#if USE_GZFILE
-  if (!this->gzfp) return false;
-  int len = gzread(this->gzfp, this->readbuf, READBUFSIZE);
-  if (len <= 0) {
-    this->gzeof = true;
-    this->readbufIndex = 0;
-    this->readbufLen = 0;
-    return false;
-  }
-  else {
+  if (this->mapaddr) {
+    // just move the window forward, no data is copied
+    this->mapoffset += this->readbufLen;
     this->readbufIndex = 0;
-    this->readbufLen = len;
+    if (this->mapoffset >= this->mapsize) {
+      this->readbufLen = 0;
+      this->fpeof = true;
+      return false;
+    }
+    size_t left = this->mapsize - this->mapoffset;
+    this->readbuf = this->mapaddr + this->mapoffset;
+    this->readbufLen = left < MAPWINDOWSIZE ? (int) left : MAPWINDOWSIZE;
     return true;
   }
-#else // ! USE_GZFILE
   if (!this->fp) return false;
-  int len = fread(this->readbuf, 1, READBUFSIZE, this->fp);
+  this->bufferOffset += this->readbufLen;
+  int len = this->readData(this->readbuf, READBUFSIZE);
   if (len <= 0) {
     this->fpeof = true;
     this->readbufIndex = 0;
@@ -667,46 +969,114 @@ dimeInput::doBufferRead()
     this->readbufLen = len;
     return true;
   }
-#endif // ! USE_GZFILE
 }
 
 //
-// puts a character back in the stream
+// Returns the offset of the next byte to be parsed, counted in the
+// (uncompressed) data.
 //
 
-void
-dimeInput::putBack(const char c)
+uint64
+dimeInput::readOffset() const
 {
-  if (readbufIndex > 0 && backBufIndex < 0)
-    readbufIndex--;
-  else
-    backBuf[++backBufIndex] = c;
+  return (this->mapaddr ? this->mapoffset : this->bufferOffset) +
+    this->readbufIndex;
 }
 
 //
-// puts back a string
+// Calls the progress callback, and schedules the next call. Returns
+// false if the callback aborted reading.
 //
 
-void
-dimeInput::putBack(const char * const string)
+bool
+dimeInput::reportProgress()
 {
-  int n = strlen(string);
-  if (n <= readbufIndex && backBufIndex < 0)
-    readbufIndex -= n;
-  else {
-    for (int i = n - 1; i >= 0; i--) 
-      backBuf[++backBufIndex] = string[i];
+  uint64 step = this->cbGranularity;
+  if (step == 0) step = this->filesize > 100 ? this->filesize / 100 : 1;
+  this->cbNext = this->readOffset() + step;
+  float pos = this->relativePosition();
+  if (pos <= this->prevposition) return true;
+  // the step is in uncompressed bytes, but the position is not
+  if (this->inflater && this->cbGranularity == 0 &&
+      pos < this->prevposition + 0.01f) return true;
+  this->prevposition = pos;
+  if (!this->callback(pos, this->callbackdata)) {
+    this->aborted = true;
+    return false;
   }
+  return true;
 }
 
 //
-// returns the first non white-space char
+// Reads up to size bytes from the file, through the read-ahead thread
+// if there is one. Returns the number of bytes read.
+//
+
+int
+dimeInput::readData(char * const buf, const int size)
+{
+  if (this->readAhead) return this->readAhead->read(buf, size);
+  return this->readFile(buf, size);
+}
+
+//
+// Reads up to size bytes from the file, decompressing it if needed.
+// Called from the read-ahead thread when there is one.
+//
+
+int
+dimeInput::readFile(char * const buf, const int size)
+{
+  if (this->inflater) return this->inflater->read(buf, size);
+  return (int) fread(buf, 1, size, this->fp);
+}
+
+//
+// Reads the first buffer from the file, and sets up decompression
+// if the file is compressed. Returns false if it is compressed and
+// can't be decompressed.
 //
 
 bool
-dimeInput::read(char &c)
+dimeInput::checkCompressed()
 {
-  return (skipWhiteSpace() && get(c));
+  if (!this->fp) return true;
+  this->fillBuffer();
+  if (!dimeInflater::isCompressed(this->readbuf, (size_t) this->readbufLen))
+    return true; // the buffer is used as is
+  this->inflater = new dimeInflater(this->fp, this->readbuf,
+                                    this->readbufLen);
+  this->readbufIndex = 0;
+  this->readbufLen = 0;
+  if (this->inflater->isValid()) return true;
+  delete this->inflater;
+  this->inflater = NULL;
+  this->fpeof = true;
+  return false;
+}
+
+//
+// Starts the read-ahead thread if requested in flags, see setFile().
+//
+
+void
+dimeInput::startReadAhead(const int flags)
+{
+  if ((flags & DIME_INPUT_READAHEAD) && this->fp)
+    this->readAhead = new dimeReadAhead(this);
+}
+
+//
+// puts a character back in the stream
+//
+
+void
+dimeInput::putBack(const char c)
+{
+  if (readbufIndex > 0 && backBufIndex < 0)
+    readbufIndex--;
+  else
+    backBuf[++backBufIndex] = c;
 }
 
 //
@@ -727,16 +1097,6 @@ dimeInput::get(char &c)
     }
   }
   c = readbuf[readbufIndex++];
-#if 0
-  if (c == 0) {
-#if USE_GZFILE
-    this->gzeof = true;
-#else // ! USE_GZFILE
-    this->fpeof = true;
-#endif
-    return false;
-  }
-#endif
   if (this->binary) {
     this->filePosition++;
   }
@@ -744,240 +1104,209 @@ dimeInput::get(char &c)
 }
 
 //
-// skip all white spaces
+// Reads n bytes of binary data. The bytes are copied in one go when
+// they are available in the read buffer.
 //
 
 bool
-dimeInput::skipWhiteSpace()
-{
-  if (this->binary) return true;
-  char c;
-  /*register*/ bool gotChar;
-  /*register*/ char endline = 0xa;
-  /*register*/ char endline2 = 0xd;
-  while((gotChar = get(c)) && iswspace(c) && c != endline && c != endline2)
-	  ;
-  if (!gotChar) return false;
-
-  // step one char back
-  putBack(c);
-  return true;
-}
-
-bool
-dimeInput::nextLine()
-{
-  if (this->binary) return true;
-
-  char c;
-  /*register*/ bool gotChar;
-  /*register*/ char endline = 0xa;
-  /*register*/ char endline2 = 0xd;
-  while((gotChar = get(c)) && c != endline && c != endline2);
-  if (!gotChar) return false;
-  while (c == endline2) { // try to read one more
-    gotChar = get(c);
-    if (!gotChar) return false;
+dimeInput::readBytes(void *data, const int n)
+{
+  if (this->backBufIndex < 0 && this->readbufIndex + n <= this->readbufLen) {
+    memcpy(data, this->readbuf + this->readbufIndex, n);
+    this->readbufIndex += n;
+    this->filePosition += n;
+    return true;
   }
-  if (c != endline && c != endline2) this->putBack(c);
-  this->filePosition++;
-  return true;
+  char *ptr = (char*) data;
+  bool ret = true;
+  for (int i = 0; i < n; i++) ret = this->get(ptr[i]);
+  return ret;
 }
 
 //
-// read an integer
+// Appends data from the file to the data left in readbuf. Returns
+// false when no more data could be read.
 //
 
 bool
-dimeInput::readInteger(long &l)
+dimeInput::fillBuffer()
 {
-  assert(!this->binary);
-  char str[TMPBUFSIZE];
-  char *s = str;
-
-  if(readChar(s, '-') || readChar(s, '+'))
-    s++;
-
-  if(! readUnsignedIntegerString(s))
-    return false;
-
-  l = strtol(str, NULL, 0);
-
+  int len = 0;
+  if (this->fp)
+    len = this->readData(this->readbuf + this->readbufLen,
+                         READBUFSIZE - this->readbufLen);
+  if (len <= 0) this->fpeof = true;
+  if (len <= 0) return false;
+  this->readbufLen += len;
   return true;
 }
 
 //
-// read an unsigned integer
+// Returns the next (ASCII) line in the stream, without the line
+// terminator. Whenever possible, the line is returned in place from
+// the read buffer, found by dime_lineend() with memchr(), which is
+// vectorized in any decent C library. The line is valid until the
+// next read operation.
 //
 
 bool
-dimeInput::readUnsignedInteger(unsigned long &l)
+dimeInput::readLine(const char *&line, int &len)
 {
   assert(!this->binary);
-  char str[TMPBUFSIZE]; 
-  if(! readUnsignedIntegerString(str))
-    return false;
-
-  l = strtoul(str, NULL, 0);
-
-  return true;
-}
-
-bool
-dimeInput::readUnsignedIntegerString(char * const str)
-{
-  assert(!this->binary);
-  int minSize = 1;
-  char *s = str;
-
-  if(readChar(s, '0')) {
-
-    if(readChar(s + 1, 'x')) {
-      s += 2 + readHexDigits(s + 2);
-      minSize = 3;
+  if (this->backBufIndex >= 0) return this->readLineSlow(line, len);
+
+  const char *start = this->readbuf + this->readbufIndex;
+  const char *end = this->readbuf + this->readbufLen;
+  const char *next;
+  const char *eol = dime_lineend(start, end, next);
+  if (eol == NULL) {
+    int avail = (int) (end - start);
+    if (memchr(start, 0xd, avail)) {
+      // the line is complete, but ends with carriage returns at the end
+      // of the buffer. Let the slow path find out if a line feed follows
+      return this->readLineSlow(line, len);
+    }
+    bool lastdata = false;
+    if (this->mapaddr) {
+      lastdata = this->mapoffset + this->readbufLen >= this->mapsize;
+    }
+    else if (avail < READBUFSIZE) {
+      // move the partial line to the front of the buffer and refill
+      memmove(this->readbuf, start, avail);
+      this->bufferOffset += this->readbufIndex;
+      this->readbufIndex = 0;
+      this->readbufLen = avail;
+      lastdata = !this->fillBuffer();
+      start = this->readbuf;
+      end = this->readbuf + this->readbufLen;
+      eol = dime_lineend(start + avail, end, next);
+      avail = this->readbufLen;
+      if (eol == NULL && memchr(start, 0xd, avail)) {
+        return this->readLineSlow(line, len);
+      }
+    }
+    if (eol == NULL) {
+      // last line of the file might not be terminated
+      if (!lastdata || avail == 0) return this->readLineSlow(line, len);
+      eol = next = end;
     }
-
-    else
-      s += 1 + readDigits(s + 1);
   }
-
-  else
-    s += readDigits(s);
-
-  if(s - str < minSize)
-    return false;
-
-  *s = '\0';
-
+  line = start;
+  len = (int) (eol - start);
+  this->readbufIndex = (int) (next - this->readbuf);
+  this->filePosition++;
   return true;
 }
 
-int
-dimeInput::readDigits(char * const string)
-{
-  assert(!this->binary);
-  char c, *s = string;
+//
+// Gathers the next line in lineBuf, one character at a time. Used
+// when the line is not available in one piece in the read buffer.
+//
 
-  while (get(c)) {
-    if(isdigit(c))
-      *s++ = c;
-    else {
-      putBack(c);
-      break;
-    }
+bool
+dimeInput::readLineSlow(const char *&line, int &len)
+{
+  char c = 0;
+  bool gotChar;
+  len = 0;
+  while ((gotChar = get(c)) && c != 0xa && c != 0xd) {
+    if (len < DXF_MAXLINELEN - 1) this->lineBuf[len++] = c;
   }
-  
-  return s - string;
+  if (!gotChar && len == 0) return false;
+  if (gotChar) {
+    while (c == 0xd && get(c));
+    if (c != 0xa && c != 0xd) this->putBack(c);
+  }
+  line = this->lineBuf;
+  this->filePosition++;
+  return true;
 }
 
 //
-// check if a character is next in stream. Writes character into
-// string if found, puts character back otherwise.
+// Copies a string from a line into lineBuf, and registers it if it
+// is a handle. If \a terminated is true, the string is zero
+// terminated in memory that is kept, and is returned in place.
 //
 
-int
-dimeInput::readChar(char * const string, char charToRead)
+const char *
+dimeInput::storeString(const char *str, int len, const bool terminated)
 {
-  assert(!this->binary);
-
-  char c;
-  int ret;
-
-  if(!get(c))
-    ret = 0;
-  
-  else if(c == charToRead) {
-    *string = c;
-    ret = 1;
+  const char *ret = str;
+  if (!terminated || len > DXF_MAXLINELEN - 1) {
+    const char *zero = (const char*) memchr(str, 0, len);
+    if (zero) len = (int) (zero - str);
+    if (len > DXF_MAXLINELEN - 1) len = DXF_MAXLINELEN - 1;
+    memmove(this->lineBuf, str, len);
+    this->lineBuf[len] = '\0';
+    ret = this->lineBuf;
   }
 
-  else {
-    putBack(c);
-    ret = 0;
+  if (this->prevwashandle) {
+    this->prevwashandle = false;
+    // handles in parts of a file are registered by the parent input
+    if (this->model && !this->parent) {
+      this->model->registerHandle(ret);
+    }
   }
-
   return ret;
 }
 
-int
-dimeInput::readHexDigits(char * const string)
-{
-  assert(!this->binary);
-
-  char c, *s = string;
-
-  while (get(c)) {
-
-    if(isxdigit(c))
-      *s++ = c;
-
-    else {
-      putBack(c);
-      break;
-    }
-  }
+//
+// reads a line holding an integer
+//
 
-  return s - string;
+bool
+dimeInput::readInteger(long &l)
+{
+  const char *s;
+  int len;
+  if (!this->readLine(s, len)) return false;
+  return dime_parse_integer(s, s + len, l);
 }
 
 //
-// reads a floating point number
+// reads a line holding a floating point number
 //
 
 bool
 dimeInput::readReal(dxfdouble &d)
 {
-  assert(!this->binary);
-
-  char str[TMPBUFSIZE];
-  int n;
-  char *s = str;
-  bool gotNum = false;
-
-  n = readChar(s, '-');
-  if(n == 0)
-    n = readChar(s, '+');
-  s += n;
-  
-  if((n = readDigits(s)) > 0) {
-    gotNum = true;
-    s += n;
+  const char *s;
+  int len;
+  if (!this->readLine(s, len)) return false;
+
+  const char *end = s + len;
+  while (s < end && dime_isblank(*s)) s++;
+  const char *str = s;
+  if (s < end && (*s == '-' || *s == '+')) s++;
+  const char *p = s;
+  while (s < end && isdigit((unsigned char) *s)) s++;
+  bool gotNum = s > p;
+  if (s < end && *s == '.') {
+    p = ++s;
+    while (s < end && isdigit((unsigned char) *s)) s++;
+    if (s > p) gotNum = true;
   }
-  
-  if(readChar(s, '.') > 0) {
-    s++;
+  if (!gotNum) return false;
 
-    if((n = readDigits(s)) > 0) {
-      gotNum = true;
-      s += n;
-    }
+  if (s < end && (*s == 'e' || *s == 'E')) {
+    s++;
+    if (s < end && (*s == '-' || *s == '+')) s++;
+    p = s;
+    while (s < end && isdigit((unsigned char) *s)) s++;
+    if (s == p) return false;
   }
 
-  if(!gotNum)
-    return false;
-
-  n = readChar(s, 'e');
-  if(n == 0)
-    n = readChar(s, 'E');
-  
-  if(n > 0) {
-    s += n;
-
-    n = readChar(s, '-');
-    if(n == 0)
-      n = readChar(s, '+');
-    s += n;
-    
-    if((n = readDigits(s)) > 0)
-      s += n;
-    
-    else
-      return false; 
+  // std::from_chars() is locale independent and correctly rounded,
+  // but doesn't accept a leading '+'
+  if (*str == '+') str++;
+  double val;
+  std::from_chars_result res = std::from_chars(str, s, val);
+  if (res.ec == std::errc::result_out_of_range) {
+    val = dime_outofrange(str, s);
   }
-  
-  *s = '\0';
-  
-  d = atof(str);
+  else if (res.ec != std::errc()) return false;
+  d = (dxfdouble) val;
   return true;
 }
 
@@ -996,7 +1325,7 @@ dimeInput::checkBinary()
     }
   }
   
-  static char binaryid[] = "AutoCAD Binary DXF";
+  static const char binaryid[] = "AutoCAD Binary DXF";
   char buf[64];
   int i;
   int n = strlen(binaryid);
@@ -1007,6 +1336,7 @@ dimeInput::checkBinary()
   if (i < n) { // probably ascii
     this->readbufIndex = 0; // assumes READBUFSIZE > 22, should be safe
     this->filePosition = 0;
+    this->reader = &dime_readers[DIME_ENCODING_ASCII];
     return false;
   }
   else {
@@ -1028,6 +1358,278 @@ dimeInput::checkBinary()
       this->putBack(test16);
       this->putBack((char)0);
     }
+    this->reader = &dime_readers[this->endianSwap ? DIME_ENCODING_SWAPPED :
+                                 DIME_ENCODING_BINARY];
     return true;
   }
 }
+
+//
+// Returns whether the rest of the input can be split into parts
+// that are read in parallel.
+//
+
+bool
+dimeInput::canSplit() const
+{
+  return this->numThreads > 1 && this->mapaddr && !this->parent &&
+    !this->hasPutBack && !this->aborted;
+}
+
+//
+// Returns the offset of the next byte to read in the memory mapped
+// input. For parts of an input, the offset is relative to the parent.
+//
+
+size_t
+dimeInput::tell() const
+{
+  assert(this->mapaddr);
+  const char *base = this->parent ? this->parent->mapaddr : this->mapaddr;
+  return (size_t) (this->readbuf - base) + this->readbufIndex -
+    (this->backBufIndex + 1);
+}
+
+//
+// Sets up this input to read the data of a memory mapped input,
+// starting at offset. position is the file position at offset. The
+// mapping is owned by parent.
+//
+
+bool
+dimeInput::initPart(dimeInput * const parent, const size_t offset,
+                    const int64 position, dimeMemHandler * const memhandler)
+{
+  assert(parent->mapaddr && offset <= parent->mapsize);
+  if (!this->init()) return false;
+  this->parent = parent;
+  this->model = parent->model;
+  this->memhandler = memhandler;
+  this->options = parent->options;
+  this->binary = parent->binary;
+  this->binary16bit = parent->binary16bit;
+  this->endianSwap = parent->endianSwap;
+  this->reader = parent->reader;
+  this->version = parent->version;
+  this->filePosition = position;
+  this->mapaddr = parent->mapaddr + offset;
+  this->ownsMap = false;
+  this->mapsize = parent->mapsize - offset;
+  this->mapoffset = 0;
+  this->readbuf = this->mapaddr;
+  this->filesize = (int64) this->mapsize;
+  this->fpeof = this->mapsize == 0;
+  return true;
+}
+
+//
+// Takes over the memory mapping of \a input, which can still be read
+// but will not unmap the file anymore. Parts of the file can then be
+// read with initPart() after \a input is gone. Returns false if \a
+// input is not memory mapped or reading from memory, see setBuffer().
+// When the mapping has been retained before, it is shared with the
+// first input retaining it, which must be deleted last.
+//
+
+bool
+dimeInput::retainMapping(dimeInput * const input)
+{
+  if (!input->mapaddr || input->parent ||
+      !(input->ownsMap || input->mapIsBuffer || input->mapRetained) ||
+      !this->init()) return false;
+  this->model = input->model;
+  this->binary = input->binary;
+  this->binary16bit = input->binary16bit;
+  this->endianSwap = input->endianSwap;
+  this->reader = input->reader;
+  this->version = input->version;
+  this->mapaddr = input->mapaddr;
+  this->ownsMap = input->ownsMap;
+  this->mapIsBuffer = input->mapIsBuffer;
+  this->mapsize = input->mapsize;
+  this->mapoffset = 0;
+  this->readbuf = this->mapaddr;
+  this->filesize = (int64) this->mapsize;
+  input->ownsMap = false;
+  input->mapRetained = true;
+  return true;
+}
+
+//
+// Reads and throws away the value of a record with group code \a
+// groupcode. In ASCII files the line is just skipped, unless it holds
+// a handle, which must be registered.
+//
+bool
+dimeInput::skipValue(const int32 groupcode)
+{
+  if (!this->binary && !this->prevwashandle) {
+    const char *line;
+    int len;
+    return this->readLine(line, len);
+  }
+  dimeParam param;
+  return dimeRecord::readRecordData(this, groupcode, param);
+}
+
+//
+// Skips the records of the current entity. The group code of the
+// next entity is put back.
+//
+bool
+dimeInput::skipRecords()
+{
+  int32 groupcode;
+  while (this->readGroupCode(groupcode)) {
+    if (groupcode == 0) {
+      this->putBackGroupCode(groupcode);
+      return true;
+    }
+    if (!this->skipValue(groupcode)) return false;
+  }
+  return false;
+}
+
+//
+// Skips the rest of the current section, including ENDSEC.
+//
+bool
+dimeInput::skipSection()
+{
+  int32 groupcode;
+  while (this->readGroupCode(groupcode)) {
+    if (groupcode == 0) {
+      const char *string = this->readString();
+      if (string == NULL) return false;
+      if (!strcmp(string, "ENDSEC")) return true;
+    }
+    else if (!this->skipValue(groupcode)) return false;
+  }
+  return false;
+}
+
+//
+// Looks ahead for the layer (group code 8) of the entity being read,
+// without consuming any data. Returns 1 and the layer name in \a
+// layername if found, 0 if the entity has no layer, and -1 if the
+// records of the entity are not available in the read buffer.
+//
+int
+dimeInput::peekLayer(char * const layername, const int maxlen)
+{
+  if (this->hasPutBack || this->backBufIndex >= 0) return -1;
+  int ret = this->binary ? this->peekLayerBinary(layername, maxlen) :
+    this->peekLayerAscii(layername, maxlen);
+  if (ret < 0 && !this->mapaddr && this->readbufIndex > 0) {
+    // move the unread data to the front of the buffer and try again
+    int avail = this->readbufLen - this->readbufIndex;
+    memmove(this->readbuf, this->readbuf + this->readbufIndex, avail);
+    this->bufferOffset += this->readbufIndex;
+    this->readbufIndex = 0;
+    this->readbufLen = avail;
+    (void) this->fillBuffer();
+    ret = this->binary ? this->peekLayerBinary(layername, maxlen) :
+      this->peekLayerAscii(layername, maxlen);
+  }
+  return ret;
+}
+
+//
+// See peekLayer().
+//
+int
+dimeInput::peekLayerAscii(char * const layername, const int maxlen) const
+{
+  const char *p = this->readbuf + this->readbufIndex;
+  const char *end = this->readbuf + this->readbufLen;
+  const char *next;
+  while (true) {
+    const char *eol = dime_lineend(p, end, next);
+    if (eol == NULL) return -1;
+    while (p < eol && dime_isblank(*p)) p++;
+    if (p < eol && *p == '+') p++;
+    int32 code;
+    std::from_chars_result res = std::from_chars(p, eol, code);
+    if (res.ec != std::errc()) return -1; // let the parser complain
+    p = next;
+    eol = dime_lineend(p, end, next);
+    if (eol == NULL) return -1;
+    if (code == 0) return 0;
+    if (code == 8) {
+      while (p < eol && dime_isblank(*p)) p++;
+      const char *zero = (const char*) memchr(p, 0, eol - p);
+      if (zero) eol = zero;
+      int len = (int) (eol - p);
+      if (len > maxlen - 1) len = maxlen - 1;
+      memcpy(layername, p, len);
+      layername[len] = '\0';
+      return 1;
+    }
+    p = next;
+  }
+}
+
+//
+// See peekLayer().
+//
+int
+dimeInput::peekLayerBinary(char * const layername, const int maxlen) const
+{
+  const char *p = this->readbuf + this->readbufIndex;
+  const char *end = this->readbuf + this->readbufLen;
+  while (true) {
+    int32 code;
+    uint16 val16;
+    if (this->binary16bit) {
+      if (end - p < 2) return -1;
+      memcpy(&val16, p, 2);
+      if (this->endianSwap) val16 = DIME_BSWAP16(val16);
+      code = (int32) val16;
+      p += 2;
+    }
+    else {
+      if (end - p < 1) return -1;
+      code = (int32) (unsigned char) *p++;
+      if (code == 255) {
+        if (end - p < 2) return -1;
+        memcpy(&val16, p, 2);
+        if (this->endianSwap) val16 = DIME_BSWAP16(val16);
+        code = (int32) (int16) val16;
+        p += 2;
+      }
+    }
+    if (code == 0) return 0;
+
+    int size;
+    switch (dimeRecord::getRecordType(code)) {
+    case dimeBase::dimeInt8RecordType:
+      size = 1;
+      break;
+    case dimeBase::dimeInt16RecordType:
+      size = 2;
+      break;
+    case dimeBase::dimeInt32RecordType:
+      size = 4;
+      break;
+    case dimeBase::dimeFloatRecordType:
+    case dimeBase::dimeDoubleRecordType:
+      size = 8; // binary files only contains doubles
+      break;
+    default: {
+      const char *zero = (const char*) memchr(p, 0, end - p);
+      if (zero == NULL) return -1;
+      if (code == 8) {
+        int len = (int) (zero - p);
+        if (len > maxlen - 1) len = maxlen - 1;
+        memcpy(layername, p, len);
+        layername[len] = '\0';
+        return 1;
+      }
+      size = (int) (zero - p) + 1;
+      break;
+    }
+    }
+    if (end - p < size) return -1;
+    p += size;
+  }
+}
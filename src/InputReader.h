@@ -0,0 +1,479 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+#ifndef DIME_INPUTREADER_H
+#define DIME_INPUTREADER_H
+
+//
+// Not installed. The readers of dimeInput are in this file so
+// dimeRecordHolder can read the records of an object with the reader
+// for the encoding of the file, without a call through a function
+// pointer for each record and value. dimePushParser finds lines and
+// parses group codes with the helpers here too.
+//
+
+#include <dime/Input.h>
+#include <dime/records/Record.h>
+#include <string.h>
+#include <float.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <charconv>
+
+#define TMPBUFSIZE 512 // temporary buffer used to read floats or integers
+
+#define LINESCANSIZE 256 // bytes searched for a line end at a time
+
+#ifdef _MSC_VER
+#define DIME_BSWAP16(x) _byteswap_ushort(x)
+#define DIME_BSWAP32(x) _byteswap_ulong(x)
+#define DIME_BSWAP64(x) _byteswap_uint64(x)
+#else // ! _MSC_VER
+#define DIME_BSWAP16(x) __builtin_bswap16(x)
+#define DIME_BSWAP32(x) __builtin_bswap32(x)
+#define DIME_BSWAP64(x) __builtin_bswap64(x)
+#endif // ! _MSC_VER
+
+// white space skipped in front of values. Line terminators are
+// handled by dimeInput::readLine()
+static inline bool
+dime_isblank(const char c)
+{
+  return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+//
+// Finds the end of the line starting at \a p, with the same rules for
+// line terminators as dimeInput::readLine(). Returns NULL if the line
+// is not complete before \a end.
+//
+static inline const char *
+dime_lineend(const char *p, const char *end, const char *&next)
+{
+  // a line ends at the first carriage return or line feed. Both are
+  // searched for with memchr(), but only LINESCANSIZE bytes at a time,
+  // as searching all of the data for a line feed first would make
+  // files with only carriage returns quadratic
+  while (p < end) {
+    const char *stop = end - p > LINESCANSIZE ? p + LINESCANSIZE : end;
+    const char *nl = (const char*) memchr(p, 0xa, stop - p);
+    const char *cr = (const char*) memchr(p, 0xd, (nl ? nl : stop) - p);
+    if (cr || nl) {
+      p = cr ? cr : nl;
+      break;
+    }
+    p = stop;
+  }
+  if (p == end) return NULL;
+  const char *q = p + 1;
+  if (*p == 0xd) {
+    // a sequence of carriage returns, optionally followed by a line
+    // feed, is one line terminator
+    while (q < end && *q == 0xd) q++;
+    if (q == end) return NULL; // a line feed might follow
+    if (*q == 0xa) q++;
+  }
+  next = q;
+  return p;
+}
+
+//
+// Parses the integer at the start of \a s, after white space. Like
+// strtol() with base 0, hexadecimal and octal numbers are accepted,
+// and characters after the number are ignored. Returns false if there
+// is no number. Used for the integer lines of dimeInput, and for the
+// group codes of dimePushParser, so both read the same group codes.
+//
+
+static inline bool
+dime_parse_integer(const char *s, const char * const end, long &l)
+{
+  while (s < end && dime_isblank(*s)) s++;
+  const char *str = s;
+  if (s < end && (*s == '-' || *s == '+')) s++;
+  const char *digits = s;
+  if (end - s > 1 && s[0] == '0' && s[1] == 'x') {
+    s += 2;
+    while (s < end && isxdigit((unsigned char) *s)) s++;
+    if (s == digits + 2) return false;
+  }
+  else {
+    while (s < end && isdigit((unsigned char) *s)) s++;
+    if (s == digits) return false;
+  }
+
+  if (digits[0] == '0' && s - digits > 1) {
+    // hex or octal number, let strtol() handle it
+    char tmp[TMPBUFSIZE];
+    int n = (int) (s - str);
+    if (n >= TMPBUFSIZE) return false;
+    memcpy(tmp, str, n);
+    tmp[n] = '\0';
+    l = strtol(tmp, NULL, 0);
+    return true;
+  }
+  long val;
+  if (std::from_chars(digits, s, val).ec != std::errc()) {
+    val = LONG_MAX; // saturate, like strtol()
+    if (*str == '-') {
+      l = LONG_MIN;
+      return true;
+    }
+  }
+  l = *str == '-' ? -val : val;
+  return true;
+}
+
+//
+// The readers of the values in one encoding of the file. Binary DXF
+// is little endian, so binary files are read with the bytes swapped
+// on big endian machines. checkBinary() selects the encoding once, so
+// no value read tests it, and the values of a record are read by
+// readRecordData() without going through the public read methods.
+//
+
+enum {
+  DIME_ENCODING_ASCII,
+  DIME_ENCODING_BINARY,
+  DIME_ENCODING_SWAPPED
+};
+
+struct dimeInputReader
+{
+  int encoding;
+  bool (*readGroupCode)(dimeInput * const in, int32 &code);
+  bool (*readInt8)(dimeInput * const in, int8 &val);
+  bool (*readInt16)(dimeInput * const in, int16 &val);
+  bool (*readInt32)(dimeInput * const in, int32 &val);
+  bool (*readFloat)(dimeInput * const in, float &val);
+  bool (*readDouble)(dimeInput * const in, dxfdouble &val);
+  const char *(*readString)(dimeInput * const in);
+  const char *(*readStringNoSkip)(dimeInput * const in);
+  bool (*readRecordData)(dimeInput * const in, const int groupcode,
+                         dimeParam &param);
+};
+
+template <int encoding>
+class dimeReader
+{
+public:
+  static bool readGroupCode(dimeInput * const in, int32 &code);
+  static bool readInt8(dimeInput * const in, int8 &val);
+  static bool readInt16(dimeInput * const in, int16 &val);
+  static bool readInt32(dimeInput * const in, int32 &val);
+  static bool readFloat(dimeInput * const in, float &val);
+  static bool readDouble(dimeInput * const in, dxfdouble &val);
+  static const char *readString(dimeInput * const in);
+  static const char *readStringNoSkip(dimeInput * const in);
+  static bool readRecordData(dimeInput * const in, const int groupcode,
+                             dimeParam &param);
+
+private:
+  static bool readBytes(dimeInput * const in, void *data, const int n);
+}; // class dimeReader
+
+//
+// Copies n bytes of binary data straight from the read buffer when
+// they are all there, which is nearly always.
+//
+
+template <int encoding>
+inline bool
+dimeReader<encoding>::readBytes(dimeInput * const in, void *data, const int n)
+{
+  if (in->backBufIndex < 0 && in->readbufIndex + n <= in->readbufLen) {
+    memcpy(data, in->readbuf + in->readbufIndex, n);
+    in->readbufIndex += n;
+    in->filePosition += n;
+    return true;
+  }
+  return in->readBytes(data, n);
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readGroupCode(dimeInput * const in, int32 &code)
+{
+  bool ret;
+  if (in->hasPutBack) {
+    in->hasPutBack = false;
+    code = in->putBackCode;
+    ret = true;
+  }
+  else {
+    if (in->callback && in->readOffset() >= in->cbNext &&
+        !in->reportProgress()) return false;
+
+    if constexpr (encoding != DIME_ENCODING_ASCII) {
+      if (in->binary16bit) {
+        int16 val16;
+        ret = readInt16(in, val16);
+        code = (int32) (uint16) val16;
+      }
+      else {
+        uint8 uval; // group code is unsigned int8
+        ret = readBytes(in, &uval, 1);
+        code = (int32) uval;
+        if (code == 255) {
+          int16 val16;
+          ret = readInt16(in, val16);
+          code = (int32) val16;
+        }
+      }
+    }
+    else {
+      //
+      // quick fix to ignore comments
+      //
+      ret = readInt32(in, code);
+      while (ret && code == 999) {
+        readString(in);
+        ret = readInt32(in, code);
+      }
+    }
+  }
+  in->prevwashandle = code == 5;
+  return ret;
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readInt8(dimeInput * const in, int8 &val)
+{
+  if constexpr (encoding != DIME_ENCODING_ASCII) {
+    return readBytes(in, &val, 1);
+  }
+  else {
+    long tmp;
+    if (in->readInteger(tmp) && tmp >= -128 && tmp <= 127) {
+      val = (int8) tmp;
+      return true;
+    }
+    return false;
+  }
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readInt16(dimeInput * const in, int16 &val)
+{
+  if constexpr (encoding != DIME_ENCODING_ASCII) {
+    uint16 tmp;
+    bool ret = readBytes(in, &tmp, 2);
+    if constexpr (encoding == DIME_ENCODING_SWAPPED) tmp = DIME_BSWAP16(tmp);
+    val = (int16) tmp;
+    return ret;
+  }
+  else {
+    long tmp;
+    if (in->readInteger(tmp) && tmp >= -32768 && tmp <= 32767) {
+      val = (int16) tmp;
+      return true;
+    }
+    return false;
+  }
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readInt32(dimeInput * const in, int32 &val)
+{
+  if constexpr (encoding != DIME_ENCODING_ASCII) {
+    uint32 tmp;
+    bool ret = readBytes(in, &tmp, 4);
+    if constexpr (encoding == DIME_ENCODING_SWAPPED) tmp = DIME_BSWAP32(tmp);
+    val = (int32) tmp;
+    return ret;
+  }
+  else {
+    long tmp;
+    if (in->readInteger(tmp)) {
+      val = tmp;
+      return true;
+    }
+    return false;
+  }
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readFloat(dimeInput * const in, float &val)
+{
+  // binary files only contains doubles
+  dxfdouble tmp;
+  bool ret = readDouble(in, tmp);
+  if (ret) {
+    val = (float) tmp;
+    if (!dime_finite(val)) {
+      int tst = dime_isinf(val);
+      if (tst < 0) {
+        val = -FLT_MAX;
+      }
+      else if (tst > 0) {
+        val = FLT_MAX;
+      }
+    }
+  }
+  return ret;
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readDouble(dimeInput * const in, dxfdouble &val)
+{
+  bool ret;
+  if constexpr (encoding != DIME_ENCODING_ASCII) {
+    static_assert(sizeof(double) == 8, "binary DXF holds 64 bit doubles");
+    uint64 tmp;
+    ret = readBytes(in, &tmp, 8);
+    if constexpr (encoding == DIME_ENCODING_SWAPPED) tmp = DIME_BSWAP64(tmp);
+    double dval;
+    memcpy(&dval, &tmp, 8);
+    val = (dxfdouble) dval;
+  }
+  else {
+    ret = in->readReal(val);
+  }
+
+  if (ret) {
+    if (!dime_finite(val)) {
+      int tst = dime_isinf(val);
+      // choose FLT_MAX as the maximum value if a number is infinite
+      if (tst < 0) {
+        val = -FLT_MAX;
+      }
+      else if (tst > 0) {
+        val = FLT_MAX;
+      }
+    }
+  }
+  return ret;
+}
+
+template <int encoding>
+const char *
+dimeReader<encoding>::readString(dimeInput * const in)
+{
+  if constexpr (encoding != DIME_ENCODING_ASCII) {
+    return readStringNoSkip(in);
+  }
+  else {
+    const char *line;
+    int len;
+    if (!in->readLine(line, len)) return NULL;
+    while (len > 0 && dime_isblank(*line)) {
+      line++;
+      len--;
+    }
+    return in->storeString(line, len);
+  }
+}
+
+template <int encoding>
+const char *
+dimeReader<encoding>::readStringNoSkip(dimeInput * const in)
+{
+  const char *line;
+  int len;
+  bool terminated = false;
+  if constexpr (encoding != DIME_ENCODING_ASCII) {
+    // binary strings are zero terminated
+    const char *zero = NULL;
+    if (in->backBufIndex < 0) {
+      line = in->readbuf + in->readbufIndex;
+      zero = (const char*) memchr(line, 0, in->readbufLen - in->readbufIndex);
+    }
+    if (zero) {
+      len = (int) (zero - line);
+      in->readbufIndex += len + 1;
+      in->filePosition += len + 1;
+      // a mapped string stays where it is until the input is gone
+      terminated = in->mapaddr != NULL;
+    }
+    else {
+      char c = 0;
+      len = 0;
+      while (in->get(c) && c != 0) {
+        if (len < DXF_MAXLINELEN - 1) in->lineBuf[len++] = c;
+      }
+      line = in->lineBuf;
+    }
+  }
+  else if (!in->readLine(line, len)) return NULL;
+  return in->storeString(line, len, terminated);
+}
+
+template <int encoding>
+bool
+dimeReader<encoding>::readRecordData(dimeInput * const in,
+                                     const int groupcode, dimeParam &param)
+{
+  bool ret;
+  switch (dimeRecord::getRecordType(groupcode)) {
+  case dimeBase::dimeInt8RecordType:
+    ret = readInt8(in, param.int8_data);
+    break;
+  case dimeBase::dimeInt16RecordType:
+    ret = readInt16(in, param.int16_data);
+    break;
+  case dimeBase::dimeInt32RecordType:
+    ret = readInt32(in, param.int32_data);
+    break;
+  case dimeBase::dimeFloatRecordType:
+    ret = readFloat(in, param.float_data);
+    break;
+  case dimeBase::dimeDoubleRecordType:
+    ret = readDouble(in, param.double_data);
+    break;
+  case dimeBase::dimeStringRecordType:
+    if (groupcode == 1) {
+      param.string_data = readStringNoSkip(in);
+    }
+    else {
+      param.string_data = readString(in);
+    }
+    ret = param.string_data != NULL;
+    break;
+  case dimeBase::dimeHexRecordType:
+    param.hex_data = readString(in);
+    ret = param.hex_data != NULL;
+    break;
+  default:
+    assert(0);
+    ret = false;
+    break;
+  }
+  return ret;
+}
+
+#endif // ! DIME_INPUTREADER_H
@@ -307,10 +307,8 @@ static dxfdouble colortable[] = {
   1,1,1};
 
 
-dimeLayer * dimeLayer::defaultLayer;
-
 // 0 seems to be the default layer name in AutoCAD
-static char defaultName[] = "0"; 
+static const char defaultName[] = "0"; 
 
 dimeLayer::dimeLayer()
   : layerName( NULL ), layerNum( -1 ), colorNum( -1 ), flags( 0 )
@@ -389,28 +387,15 @@ dimeLayer::colorToRGB(const int colornum,
   Returns true if this is the default layer.
 */
 
-
-void 
-dimeLayer::cleanup_default_layer(void)
-{
-  delete defaultLayer;
-  defaultLayer = NULL;
-}
-
 /*!
   Returns a pointer to the default layer.
 */
 const dimeLayer *
 dimeLayer::getDefaultLayer()
 {
-  if (defaultLayer == NULL) {
-    defaultLayer = new dimeLayer;
-    defaultLayer->layerName = defaultName;
-    defaultLayer->layerNum = 0;
-    defaultLayer->colorNum = 7; // white...
-    atexit(cleanup_default_layer);
-  }
-  return defaultLayer;
+  // constructed once, on first use (thread safe)
+  static const dimeLayer defaultLayer(defaultName, 0, 7, 0); // white...
+  return &defaultLayer;
 }
 
 
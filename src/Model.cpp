@@ -76,6 +76,7 @@ dimeModel::getVersion(int &major, int &minor)
 
 #include <dime/Input.h>
 #include <dime/Output.h>
+#include <dime/ReadOptions.h>
 #include <dime/util/Dict.h>
 #include <dime/util/MemHandler.h>
 #include <dime/State.h>
@@ -92,6 +93,20 @@ dimeModel::getVersion(int &major, int &minor)
 #define SECTIONID "SECTION"
 #define EOFID     "EOF"
 
+// maps characters to hex digit values, 0xff for other characters
+static const unsigned char dime_hexvalue[256] = {
+#define X 0xff
+  X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,
+  X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X, 0,1,2,3,4,5,6,7,8,9,X,X,X,X,X,X,
+  X,10,11,12,13,14,15,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,
+  X,10,11,12,13,14,15,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,
+  X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,
+  X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,
+  X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,
+  X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X, X,X,X,X,X,X,X,X,X,X,X,X,X,X,X,X
+#undef X
+};
+
 /*!
   Constructor. If \a usememhandler is \e TRUE, the dimeMemHandler will
   be used to allocate entities and records.
@@ -99,7 +114,9 @@ dimeModel::getVersion(int &major, int &minor)
 dimeModel::dimeModel(const bool usememhandler)
   : refDict( NULL ), 
   layerDict( NULL ), 
+  lastLayer( NULL ), 
   memoryHandler( NULL ), 
+  pinnedInput( NULL ),
   largestHandle(0),
   usememhandler(usememhandler)
 {
@@ -122,6 +139,7 @@ dimeModel::~dimeModel()
     delete this->sections[i];
   
   delete this->memoryHandler; // free memory :)
+  delete this->pinnedInput; // the strings were borrowed from it
 }
 
 /*!
@@ -168,11 +186,14 @@ dimeModel::init()
   delete this->refDict;
   delete this->layerDict;
   delete this->memoryHandler;
+  delete this->pinnedInput;
 
   // set all to NULL first to support exceptions.
   this->refDict = NULL;
   this->layerDict = NULL;
+  this->lastLayer = NULL;
   this->memoryHandler = NULL;
+  this->pinnedInput = NULL;
   
   this->refDict = new dimeDict;
   this->layerDict = new dimeDict(101); // relatively small
@@ -182,15 +203,36 @@ dimeModel::init()
 }
 
 /*!
-  Reads the model file into the internal structures.
+  Reads the model file into the internal structures. If \a options is
+  not \e NULL, only the sections, entities and layers specified there
+  are read, and the rest of the file is skipped.
+
+  \sa dimeReadOptions
 */
 
 bool 
-dimeModel::read(dimeInput * const in)
+dimeModel::read(dimeInput * const in, const dimeReadOptions * const options)
 {
   in->model = this; // _very_ important
+  in->options = options;
+  in->skipChildren = false;
 
   this->init();
+
+  if (options && options->getBorrowStrings() && this->memoryHandler &&
+      in->isBinary()) {
+    // keep the mapping for as long as the model, and let the strings
+    // of the model point into it
+    this->pinnedInput = new dimeInput;
+    if (this->pinnedInput->retainMapping(in)) {
+      this->memoryHandler->borrowStrings(this->pinnedInput->mapaddr,
+                                         this->pinnedInput->mapsize);
+    }
+    else {
+      delete this->pinnedInput;
+      this->pinnedInput = NULL;
+    }
+  }
   
   int32 groupcode;
   const char *string;
@@ -218,6 +260,11 @@ dimeModel::read(dimeInput * const in)
       string = in->readString();
       ok = ok && string != NULL && groupcode == 2;
       if (!ok) break;
+      if (options && !options->isSectionKept(string)) {
+        ok = in->skipSection();
+        if (!ok) break;
+        continue;
+      }
       section = dimeSection::createSection(string, in->getMemHandler());
       ok = section != NULL && section->read(in);
       if (!ok) break;
@@ -229,6 +276,7 @@ dimeModel::read(dimeInput * const in)
     }
     else break; // something unexpected has happened
   }	
+  in->options = NULL;
   if (!ok) {
     if (in->aborted) {
 #ifndef NDEBUG
@@ -237,7 +285,8 @@ dimeModel::read(dimeInput * const in)
     }
     else {
 #ifndef NDEBUG
-      fprintf( stderr, "DXF loading failed at line: %d\n", in->getFilePosition());
+      fprintf( stderr, "DXF loading failed at line: %lld\n",
+               (long long) in->getFilePosition());
 #endif
     }
   }
@@ -245,7 +294,10 @@ dimeModel::read(dimeInput * const in)
     dimeBlocksSection *bs = (dimeBlocksSection*)this->findSection("BLOCKS");
     dimeEntitiesSection *es = (dimeEntitiesSection*)this->findSection("ENTITIES");
     if (bs) bs->fixReferences(this);
-    if (es) es->fixReferences(this);
+    // don't complain about missing blocks when they were not read
+    if (es && (bs || !options || options->isSectionKept("BLOCKS"))) {
+      es->fixReferences(this);
+    }
 //#ifndef NDEBUG
 //    fprintf(stderr,"dimeModel::largestHandle: %d\n", this->largestHandle);
 //#endif
@@ -255,7 +307,8 @@ dimeModel::read(dimeInput * const in)
 
 /*!
   Writes the model to file. Currently only DXF files are supported, but
-  hopefully DWG will be supported soon.
+  hopefully DWG will be supported soon. Buffered output in \a out is
+  flushed before returning.
 */
 
 bool 
@@ -280,6 +333,9 @@ dimeModel::write(dimeOutput * const out)
   }
   (void)out->writeHeader();
   int i, n = this->headerComments.count();
+  // a binary file must start with a section, so the comments are
+  // only written to ASCII files
+  if (out->isBinary()) n = 0;
   for (i = 0; i < n; i++) {
     this->headerComments[i]->write(out);
   }
@@ -290,10 +346,8 @@ dimeModel::write(dimeOutput * const out)
     out->writeString(SECTIONID);
     if (!sections[i]->write(out)) break;
   }
-  if (i == n) {
-    return out->writeGroupCode(0) && out->writeString(EOFID);
-  }
-  return false;
+  bool ok = i == n && out->writeGroupCode(0) && out->writeString(EOFID);
+  return out->flush() && ok;
 }
 
 /*!
@@ -305,6 +359,7 @@ dimeModel::write(dimeOutput * const out)
 const char *
 dimeModel::addReference(const char * const name, void *id)
 {
+  std::lock_guard<std::mutex> lock(this->refMutex);
   char *ptr = NULL;
   refDict->enter(name, ptr, id);
   return (const char*) ptr;
@@ -317,6 +372,7 @@ dimeModel::addReference(const char * const name, void *id)
 void *
 dimeModel::findReference(const char * const name) const
 {
+  std::lock_guard<std::mutex> lock(this->refMutex);
   void *id;
   if (refDict->find(name, id))
     return id;
@@ -330,6 +386,7 @@ dimeModel::findReference(const char * const name) const
 const char *
 dimeModel::findRefStringPtr(const char * const name) const
 {
+  std::lock_guard<std::mutex> lock(this->refMutex);
   return refDict->find(name);
 }
 
@@ -340,6 +397,7 @@ dimeModel::findRefStringPtr(const char * const name) const
 void
 dimeModel::removeReference(const char * const name)
 {
+  std::lock_guard<std::mutex> lock(this->refMutex);
   refDict->remove(name);
 }
 
@@ -356,12 +414,21 @@ dimeModel::getMemHandler()
 /*!
   Adds a layer to the list of layers. If the layer already exists, a
   pointer to the existing layer will be returned.
+
+  Entities usually come in runs on the same layer, so the layer
+  returned last time is checked before the dictionary. Layer names
+  are stored once, so passing the name of an existing layer
+  (dimeLayer::getLayerName()) makes this a pointer compare.
 */
 
 const dimeLayer *
 dimeModel::addLayer(const char * const name, const int16 colnum,
                     const int16 flags)
 {
+  const dimeLayer *last = this->lastLayer.load(std::memory_order_acquire);
+  if (last && (last->layerName == name ||
+               !strcmp(last->layerName, name))) return last;
+
   void *temp = NULL;
   if (!this->layerDict->find(name, temp)) {
     // default layer has layer-num = 0, hence the + 1
@@ -372,9 +439,11 @@ dimeModel::addLayer(const char * const name, const int16 colnum,
     // this is a little hack...
     layer->layerName = ptr; // need a pointer that won't disappear
     this->layers.append(layer);
-    return layer;
+    temp = layer;
   }
-  return (dimeLayer*) temp;
+  // several threads may read entities at the same time
+  this->lastLayer.store((const dimeLayer*) temp, std::memory_order_release);
+  return (const dimeLayer*) temp;
 }
 
 /*!
@@ -425,6 +494,7 @@ dimeModel::getNumLayers() const
 const char *
 dimeModel::addBlock(const char * const blockname, dimeBlock * const block)
 {  
+  std::lock_guard<std::mutex> lock(this->refMutex);
   char *ptr = NULL;
   refDict->enter(blockname, ptr, block);
   return (const char*) ptr;
@@ -438,6 +508,7 @@ dimeModel::addBlock(const char * const blockname, dimeBlock * const block)
 dimeBlock *
 dimeModel::findBlock(const char * const blockname)
 {
+  std::lock_guard<std::mutex> lock(this->refMutex);
   void *tmp = NULL;
   this->refDict->find(blockname, tmp);
   return (dimeBlock*)tmp;
@@ -640,7 +711,7 @@ dimeModel::removeSection(const int idx)
   AutoCAD...
 */
 void
-dimeModel::registerHandle(const int handle)
+dimeModel::registerHandle(const uint64 handle)
 {
   if (handle >= this->largestHandle) {
     this->largestHandle = handle;
@@ -653,22 +724,27 @@ dimeModel::registerHandle(const int handle)
 void
 dimeModel::registerHandle(const char * const handle)
 {
-  int num;
-  if (sscanf(handle, "%x", &num)) {
-    this->registerHandle(num);
+  const unsigned char *ptr = (const unsigned char*) handle;
+  while (*ptr == ' ' || *ptr == '\t') ptr++;
+  if (dime_hexvalue[*ptr] == 0xff) return; // not a handle
+  uint64 num = 0;
+  unsigned int digit;
+  while ((digit = dime_hexvalue[*ptr++]) != 0xff) {
+    num = (num << 4) | digit;
   }
+  this->registerHandle(num);
 }
 
-int
+uint64
 dimeModel::getUniqueHandle()
 {
   return ++this->largestHandle;
 }
 
 const char *
-dimeModel::getUniqueHandle(char *buf, const int)
+dimeModel::getUniqueHandle(char *buf, const int bufsize)
 {
-  sprintf(buf,"%x", getUniqueHandle());
+  snprintf(buf, bufsize, "%llx", (unsigned long long) getUniqueHandle());
   return buf;
 }
 
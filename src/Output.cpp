@@ -33,37 +33,148 @@
 /*!
   \class dimeOutput dime/Output.h
   \brief The dimeOutput class handles writing of DXF and DXB files.
+
+  The output is formatted into an internal buffer, which is written to
+  the file when it is full, by flush() and in the destructor.
+
+  Binary DXF files are written with 8 bit group codes, where group
+  codes of 255 and above are written as 255 followed by a 16 bit group
+  code, like in AutoCAD Release 12. Values are written in the encoding
+  of the record type of the group code, see dimeRecord::getRecordType().
 */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <charconv>
+
 #include <dime/Output.h>
+#include <dime/records/Record.h>
 #define _USE_MATH_DEFINES	// PWH. 2012.07.21
 #include <math.h>
 
 #include <Windows.h>	// PWH.
 
-/*!
-  \fn bool dimeOutput::writeHeader()
-  This method does nothing now, but if binary files are supported in the
-  future, it must be called.
-*/
+#define WRITEBUFSIZE 65536
+
+#ifdef _WIN32
+#define DIME_WRITE(fd, buf, size) _write(fd, buf, (unsigned int) (size))
+#else
+#define DIME_WRITE(fd, buf, size) write(fd, buf, size)
+#endif // ! _WIN32
+
+// Longest formatted number, including the newline. A double written
+// like printf("%g") is at most "-1.23457e-308", but leave room for
+// the longer NaN strings of some C libraries.
+#define MAXNUMBERLEN 32
+
+//
+// Formats \a val right justified in a field of \a width characters,
+// followed by a newline, like printf("%*d\n"). Returns the number of
+// characters written to \a ptr.
+//
+
+static inline int
+dime_format_int(char * const ptr, const long val, const int width)
+{
+  char tmp[MAXNUMBERLEN];
+  const int len = (int) (std::to_chars(tmp, tmp + sizeof(tmp), val).ptr - tmp);
+  const int pad = len < width ? width - len : 0;
+  memset(ptr, ' ', pad);
+  memcpy(ptr + pad, tmp, len);
+  ptr[pad + len] = '\n';
+  return pad + len + 1;
+}
+
+//
+// Formats \a val followed by a newline. Integer values below one million
+// are written with one decimal, like printf("%.1f\n"), other values like
+// printf("%g\n"). Returns the number of characters written to \a ptr.
+//
+
+template <class T>
+static inline int
+dime_format_real(char * const ptr, const T val)
+{
+  char *s = ptr;
+  if (fabs(val) < 1000000.0 && floor(val) == val) {
+    if (val == 0 && signbit(val)) *s++ = '-';
+    s = std::to_chars(s, ptr + MAXNUMBERLEN, (long) val).ptr;
+    *s++ = '.';
+    *s++ = '0';
+  }
+  else {
+    s = std::to_chars(s, ptr + MAXNUMBERLEN, val,
+                      std::chars_format::general, 6).ptr;
+  }
+  *s++ = '\n';
+  return (int) (s - ptr);
+}
+
+//
+// Stores the lowest \a n bytes of \a val at \a ptr, least significant
+// byte first, like binary DXF files do on all platforms.
+//
+
+static inline void
+dime_put_le(char * const ptr, const uint64 val, const int n)
+{
+  for (int i = 0; i < n; i++) ptr[i] = (char) (val >> (8 * i));
+}
 
 /*!
   Constructor.
 */
 
 dimeOutput::dimeOutput()
-  : fp( NULL ), binary( false ), callback( NULL ), callbackdata( NULL ),
+  : fp( NULL ), fd( -1 ), binary( false ), buffer( NULL ), bufferPos( 0 ),
+    failed( false ), recordType( dimeBase::dimeStringRecordType ),
+    callback( NULL ), callbackdata( NULL ),
     aborted( false ), didOpenFile(false)
 {
 }
 
 /*!
-  Destructor.
+  Destructor. Writes any buffered output to the file.
 */
 
 dimeOutput::~dimeOutput()
 {
-  if (this->fp && this->didOpenFile) fclose(this->fp);
+  this->setFp(NULL, false);
+  delete [] this->buffer;
+}
+
+//
+// Flushes the buffer to the current file, closes it if it was opened
+// by us, and starts using \a fp.
+//
+
+void
+dimeOutput::setFp(FILE * const fp, const bool didopen)
+{
+  if (this->fp) {
+    (void) this->flush();
+    if (this->didOpenFile) fclose(this->fp);
+  }
+  this->fp = fp;
+  this->didOpenFile = didopen;
+  this->failed = false;
+  this->fd = -1;
+  if (fp) {
+    // the buffer is written directly to the file descriptor, so anything
+    // already written to the stream must come first
+    fflush(fp);
+    this->fd = fileno(fp);
+  }
 }
 
 /*!
@@ -92,30 +203,27 @@ dimeOutput::setCallback(const int num_records,
 bool
 dimeOutput::setFilename(const char * const filename)
 {
-  if (this->fp && this->didOpenFile) fclose(this->fp);
-  this->fp = fopen(filename, "wb");
-  this->didOpenFile = true;
+  this->setFp(fopen(filename, "wb"), true);
   return (this->fp != NULL);
 }
 
 /*!
   Sets the output stream. \a fp should be a valid file/stream, and
-  it will not be closed in the destructor.
+  it will not be closed in the destructor. Output is buffered by
+  dimeOutput, and \a fp should not be used directly before flush()
+  has been called.
  */
 bool 
 dimeOutput::setFileHandle(FILE *fp)
 {
-  if (this->fp && this->didOpenFile) fclose(this->fp);
-
   assert(fp);
-  this->fp = fp;
-  this->didOpenFile = false;
+  this->setFp(fp, false);
   return true;
 }
 
 /*!
-  Sets binary (DXB) or ASCII (DXF) format. Currently only ASCII
-  is supported.
+  Sets binary (DXB) or ASCII (DXF) format. Must be set before anything
+  is written.
 */
 
 void
@@ -134,6 +242,71 @@ dimeOutput::isBinary() const
   return this->binary;
 }
 
+/*!
+  Writes the buffered output to the file. Returns \e false if
+  an error occurred when writing this or earlier output.
+*/
+
+bool
+dimeOutput::flush()
+{
+  int size = this->bufferPos;
+  this->bufferPos = 0;
+  if (size && !this->writeData(this->buffer, size)) this->failed = true;
+  return !this->failed;
+}
+
+//
+// Writes \a size bytes directly to the file.
+//
+
+bool
+dimeOutput::writeData(const char * const data, const size_t size)
+{
+  if (!this->fp) return false;
+  if (this->fd < 0) { // not a real file
+    return fwrite(data, 1, size, this->fp) == size;
+  }
+  size_t done = 0;
+  while (done < size) {
+    long n = (long) DIME_WRITE(this->fd, data + done, size - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+//
+// Returns a pointer to room for \a size bytes in the buffer, flushing
+// it first if needed. \a size must not exceed WRITEBUFSIZE.
+//
+
+char *
+dimeOutput::reserve(const int size)
+{
+  if (!this->buffer) this->buffer = new char[WRITEBUFSIZE];
+  if (this->bufferPos + size > WRITEBUFSIZE) (void) this->flush();
+  return this->buffer + this->bufferPos;
+}
+
+/*!
+  Writes the sentinel which starts a binary DXF file. Does nothing
+  for ASCII files. Must be called before anything else is written.
+*/
+
+bool
+dimeOutput::writeHeader()
+{
+  if (this->binary) {
+    static const char sentinel[] = "AutoCAD Binary DXF\r\n\032";
+    // the terminating zero is part of the sentinel
+    memcpy(this->reserve(sizeof(sentinel)), sentinel, sizeof(sentinel));
+    this->bufferPos += sizeof(sentinel);
+  }
+  return !this->failed;
+}
+
 /*!
   Writes a record group code to the file.
 */
@@ -150,7 +323,24 @@ dimeOutput::writeGroupCode(const int groupcode)
     }
     this->numwrites++;
   }
-  return fprintf(this->fp, "%3d\n", groupcode) > 0;
+  if (this->binary) {
+    char *ptr = this->reserve(3);
+    if (groupcode >= 0 && groupcode < 255) {
+      ptr[0] = (char) groupcode;
+      this->bufferPos++;
+    }
+    else {
+      ptr[0] = (char) 255;
+      dime_put_le(ptr + 1, (uint16) groupcode, 2);
+      this->bufferPos += 3;
+    }
+    this->recordType = dimeRecord::getRecordType(groupcode);
+  }
+  else {
+    this->bufferPos +=
+      dime_format_int(this->reserve(MAXNUMBERLEN), groupcode, 3);
+  }
+  return !this->failed;
 }
 
 /*!
@@ -160,7 +350,9 @@ dimeOutput::writeGroupCode(const int groupcode)
 bool
 dimeOutput::writeInt8(const int8 val)
 {
-  return fprintf(this->fp,"%6d\n", (int)val) > 0;
+  if (this->binary) this->putBinaryInteger(val);
+  else this->bufferPos += dime_format_int(this->reserve(MAXNUMBERLEN), val, 6);
+  return !this->failed;
 }
 
 /*!
@@ -170,7 +362,9 @@ dimeOutput::writeInt8(const int8 val)
 bool
 dimeOutput::writeInt16(const int16 val)
 {
-  return fprintf(this->fp,"%6d\n", (int)val) > 0;
+  if (this->binary) this->putBinaryInteger(val);
+  else this->bufferPos += dime_format_int(this->reserve(MAXNUMBERLEN), val, 6);
+  return !this->failed;
 }
 
 /*!
@@ -180,7 +374,9 @@ dimeOutput::writeInt16(const int16 val)
 bool
 dimeOutput::writeInt32(const int32 val)
 {
-  return fprintf(this->fp,"%6d\n", val) > 0;
+  if (this->binary) this->putBinaryInteger(val);
+  else this->bufferPos += dime_format_int(this->reserve(MAXNUMBERLEN), val, 6);
+  return !this->failed;
 }
 
 /*!
@@ -190,14 +386,9 @@ dimeOutput::writeInt32(const int32 val)
 bool
 dimeOutput::writeFloat(const float val)
 {
-  // Check for integer value, force decimal and one zero.
-  if( fabsf( val ) < 1000000.0 && floorf( val ) == val ) {
-    return fprintf(this->fp, "%.1f\n", val);
-  }
-  else {
-    return fprintf(this->fp, "%g\n", val);
-//    return fprintf(this->fp, "%#f\n", val);
-  }
+  if (this->binary) this->putBinaryDouble(val);
+  else this->bufferPos += dime_format_real(this->reserve(MAXNUMBERLEN), val);
+  return !this->failed;
 }
 
 /*!
@@ -207,14 +398,9 @@ dimeOutput::writeFloat(const float val)
 bool
 dimeOutput::writeDouble(const dxfdouble val)
 {
-  // Check for integer value, force decimal and one zero.
-  if( fabs( val ) < 1000000.0 && floor( val ) == val ) {
-    return fprintf(this->fp, "%.1f\n", val);
-  }
-  else {
-    return fprintf(this->fp,"%g\n", val) > 0;
-//    return fprintf(this->fp,"%#f\n", val) > 0;
-  }
+  if (this->binary) this->putBinaryDouble(val);
+  else this->bufferPos += dime_format_real(this->reserve(MAXNUMBERLEN), val);
+  return !this->failed;
 }
 
 /*!
@@ -224,7 +410,118 @@ dimeOutput::writeDouble(const dxfdouble val)
 bool
 dimeOutput::writeString(const char * const str)
 {
-  return fprintf(this->fp, "%s\n", str) > 0;
+  if (this->binary) this->putBinaryString(str);
+  else this->putString(str, '\n');
+  return !this->failed;
+}
+
+//
+// Writes \a str followed by \a terminator.
+//
+
+void
+dimeOutput::putString(const char * const str, const char terminator)
+{
+  const size_t len = strlen(str);
+  if (len < WRITEBUFSIZE) {
+    char *ptr = this->reserve((int) len + 1);
+    memcpy(ptr, str, len);
+    ptr[len] = terminator;
+    this->bufferPos += (int) len + 1;
+  }
+  else { // too long for the buffer
+    if (!this->flush() || !this->writeData(str, len)) this->failed = true;
+    *this->reserve(1) = terminator;
+    this->bufferPos++;
+  }
+}
+
+//
+// The putBinary methods write a value in the binary encoding for the
+// record type of the last group code. A value of another type than the
+// record type is converted, so the file can always be read back.
+//
+
+void
+dimeOutput::putBinaryInteger(const int32 val)
+{
+  char *ptr;
+  switch (this->recordType) {
+  case dimeBase::dimeInt8RecordType:
+    *this->reserve(1) = (char) val;
+    this->bufferPos++;
+    break;
+  case dimeBase::dimeInt16RecordType:
+    ptr = this->reserve(2);
+    dime_put_le(ptr, (uint16) val, 2);
+    this->bufferPos += 2;
+    break;
+  case dimeBase::dimeInt32RecordType:
+    ptr = this->reserve(4);
+    dime_put_le(ptr, (uint32) val, 4);
+    this->bufferPos += 4;
+    break;
+  case dimeBase::dimeFloatRecordType:
+  case dimeBase::dimeDoubleRecordType:
+    this->putBinaryDouble((dxfdouble) val);
+    break;
+  default:
+    {
+      char tmp[MAXNUMBERLEN];
+      *std::to_chars(tmp, tmp + sizeof(tmp) - 1, (long) val).ptr = 0;
+      this->putString(tmp, '\0');
+    }
+    break;
+  }
+}
+
+void
+dimeOutput::putBinaryDouble(const dxfdouble val)
+{
+  switch (this->recordType) {
+  case dimeBase::dimeInt8RecordType:
+  case dimeBase::dimeInt16RecordType:
+  case dimeBase::dimeInt32RecordType:
+    this->putBinaryInteger((int32) val);
+    break;
+  case dimeBase::dimeFloatRecordType: // binary files only contain doubles
+  case dimeBase::dimeDoubleRecordType:
+    {
+      static_assert(sizeof(double) == 8, "binary DXF holds 64 bit doubles");
+      const double dval = (double) val;
+      uint64 bits;
+      memcpy(&bits, &dval, 8);
+      dime_put_le(this->reserve(8), bits, 8);
+      this->bufferPos += 8;
+    }
+    break;
+  default:
+    {
+      char tmp[MAXNUMBERLEN];
+      tmp[dime_format_real(tmp, val) - 1] = 0; // replace the newline
+      this->putString(tmp, '\0');
+    }
+    break;
+  }
+}
+
+void
+dimeOutput::putBinaryString(const char * const str)
+{
+  switch (this->recordType) {
+  case dimeBase::dimeInt8RecordType:
+  case dimeBase::dimeInt16RecordType:
+  case dimeBase::dimeInt32RecordType:
+    this->putBinaryInteger((int32) strtol(str, NULL, 10));
+    break;
+  case dimeBase::dimeFloatRecordType:
+  case dimeBase::dimeDoubleRecordType:
+    this->putBinaryDouble((dxfdouble) strtod(str, NULL));
+    break;
+  default:
+    this->putString(str, '\0');
+    break;
+  }
 }
 
 //<< PWH
@@ -232,7 +529,7 @@ bool dimeOutput::writeString(const wchar_t * const str) {
 	BOOL bUsed = FALSE;
 	char buf[4096] = "";
 	WideCharToMultiByte(CP_UTF8, 0, str, wcslen(str), buf, sizeof(buf), 0, &bUsed);
-	return fprintf(this->fp, "%s\n", buf) > 0;
+	return this->writeString(buf);
 }
 //>>
 
@@ -242,4 +539,3 @@ dimeOutput::getUniqueHandleId()
   // FIXME
   return 1;
 }
-
@@ -0,0 +1,737 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class dimePushParser dime/PushParser.h
+  \brief The dimePushParser class parses a DXF file handed to it in
+  chunks of any size.
+
+  Where dimeModel::read() and dimeEntityStream pull their data from a
+  dimeInput, and block until it is available, this class is fed the
+  data as it arrives, for instance from a socket in an event loop.
+  Each call to feed() parses as much as possible of the data fed so
+  far, and keeps the rest, which may end anywhere, even in the middle
+  of a group code or a value, until the next call. finish() is called
+  when there is no more data.
+
+  The entities in the BLOCKS and ENTITIES sections are passed to the
+  entity callback as soon as they have been read, i.e. when the group
+  code of the next entity has arrived, and are freed when the
+  callback returns. Only the data of the entity being read is kept,
+  so the memory used does not depend on the size of the file. As for
+  dimeEntityStream, blocks are passed as dimeBlock entities, including
+  their entities, and INSERT entities are not connected to their
+  blocks.
+
+  The other sections are kept until their ENDSEC has arrived, and then
+  read into the model available from getModel(). The section callback
+  is called when the name of a section has been read, and again after
+  the section has been read.
+
+  Both ASCII and binary files are supported, but not compressed ones.
+  If a callback returns \e false, parsing stops, and feed() and
+  finish() return \e false.
+
+  Typical usage:
+
+  \code
+  static bool
+  entity_cb(const char *section, dimeEntity *entity, void *userdata)
+  {
+    // do something with the entity
+    return true;
+  }
+
+  dimePushParser parser;
+  parser.setEntityCallback(entity_cb, NULL);
+  while ((len = receive(buf, sizeof(buf))) > 0) {
+    if (!parser.feed(buf, len)) return false;
+  }
+  if (!parser.finish()) return false;
+  \endcode
+*/
+
+#include <dime/PushParser.h>
+#include <dime/entities/Entity.h>
+#include <dime/entities/Block.h>
+#include <dime/records/Record.h>
+#include <dime/sections/Section.h>
+#include <dime/util/MemHandler.h>
+#include "InputReader.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// room in front of the data for the sentinel of binary files
+#define HEADROOM 22
+
+enum {
+  DIME_PUSH_ENCODING,    // the encoding is not known yet
+  DIME_PUSH_TOPLEVEL,    // between sections
+  DIME_PUSH_SECTIONNAME, // after 0 SECTION
+  DIME_PUSH_SECTION,     // in a section which is kept until ENDSEC
+  DIME_PUSH_ENTITIES,    // in a section which is read entity by entity
+  DIME_PUSH_DONE         // after 0 EOF
+};
+
+//
+// Returns true if the value \a value of length \a len equals \a name.
+//
+
+static inline bool
+dime_push_match(const char * const value, const int len,
+                const char * const name)
+{
+  return !strncmp(value, name, len) && name[len] == '\0';
+}
+
+/*!
+  Constructor.
+*/
+
+dimePushParser::dimePushParser()
+  : model( false ), entity( NULL ), entityCallback( NULL ),
+    entityData( NULL ), sectionCallback( NULL ), sectionData( NULL ),
+    buffer( NULL ), bufferSize( 0 )
+{
+  this->memhandler = new dimeMemHandler;
+  this->input.model = &this->model;
+  this->reset();
+}
+
+/*!
+  Destructor.
+*/
+
+dimePushParser::~dimePushParser()
+{
+  this->recycle();
+  delete this->memhandler;
+  delete [] this->buffer;
+}
+
+/*!
+  Sets the function called for each entity in the BLOCKS and ENTITIES
+  sections. The name of the section and the entity are passed to \a
+  callback, together with \a userdata. The entity is owned by the
+  parser, and freed when \a callback returns, so copy what you need.
+  Return \e false from \a callback to stop parsing.
+*/
+
+void
+dimePushParser::setEntityCallback(dimePushEntityCallback *callback,
+                                  void *userdata)
+{
+  this->entityCallback = callback;
+  this->entityData = userdata;
+}
+
+/*!
+  Sets the function called with \a begin set to \e true when the
+  name of a section has been read, and with \a begin set to \e false
+  at the end of the section. Sections other than BLOCKS and ENTITIES
+  are available from getModel() at the end of the section. Return \e
+  false from \a callback to stop parsing.
+*/
+
+void
+dimePushParser::setSectionCallback(dimePushSectionCallback *callback,
+                                   void *userdata)
+{
+  this->sectionCallback = callback;
+  this->sectionData = userdata;
+}
+
+/*!
+  Parses the next \a len bytes of the file in \a data, and calls the
+  callbacks for the entities and sections completed by them. Data
+  not completing a record is kept for the next call, \a data is not
+  used after this call. Returns \e false if an error occurred, or if
+  a callback stopped parsing, now or earlier.
+*/
+
+bool
+dimePushParser::feed(const char * const data, const size_t len)
+{
+  if (this->error || this->aborted) return false;
+  if (this->state == DIME_PUSH_DONE) return true; // ignore trailing data
+
+  this->compact();
+  if (this->bufferLen + len > this->bufferSize) {
+    size_t size = this->bufferSize * 2;
+    if (size < this->bufferLen + len) size = this->bufferLen + len;
+    if (size < 65536) size = 65536;
+    char *newbuffer = new char[size];
+    if (this->buffer) memcpy(newbuffer, this->buffer, this->bufferLen);
+    delete [] this->buffer;
+    this->buffer = newbuffer;
+    this->bufferSize = size;
+  }
+  memcpy(this->buffer + this->bufferLen, data, len);
+  this->bufferLen += len;
+
+  if (this->state == DIME_PUSH_ENCODING && !this->checkEncoding(false)) {
+    return true;
+  }
+  return this->parse();
+}
+
+/*!
+  Parses the data kept from the last call to feed(), which is the end
+  of the file. Returns \e false if the file was incomplete, if an
+  error occurred, or if a callback stopped parsing.
+*/
+
+bool
+dimePushParser::finish()
+{
+  if (this->error || this->aborted) return false;
+  if (this->state == DIME_PUSH_ENCODING && this->bufferLen > this->scanPos) {
+    this->checkEncoding(true);
+    if (!this->parse()) return false;
+  }
+  if (this->state != DIME_PUSH_DONE && !this->binary &&
+      this->bufferLen > this->scanPos &&
+      this->buffer[this->bufferLen - 1] != 0xa) {
+    // the last line of the file might not be terminated
+    if (!this->feed("\n", 1)) return false;
+  }
+  if (this->state != DIME_PUSH_DONE) {
+    fprintf(stderr, "Unexpected end of DXF data at position: %lld\n",
+            (long long) this->position);
+    this->error = true;
+  }
+  return !this->error;
+}
+
+/*!
+  Forgets everything fed to the parser, and empties the model, so
+  that another file can be parsed. The callbacks are kept.
+*/
+
+void
+dimePushParser::reset()
+{
+  this->recycle();
+  this->model.init();
+  this->bufferLen = HEADROOM;
+  this->scanPos = HEADROOM;
+  this->unitStart = 0;
+  this->unitPosition = 0;
+  this->unitIsBlock = false;
+  this->position = 0;
+  this->recordPosition = 0;
+  this->state = DIME_PUSH_ENCODING;
+  this->binary = false;
+  this->binary16bit = false;
+  this->section[0] = '\0';
+  this->error = false;
+  this->aborted = false;
+}
+
+/*!
+  Returns \e true when the end of the file (0 EOF) has been parsed.
+*/
+
+bool
+dimePushParser::isDone() const
+{
+  return this->state == DIME_PUSH_DONE;
+}
+
+/*!
+  Returns \e true if an error occurred while parsing.
+*/
+
+bool
+dimePushParser::hasError() const
+{
+  return this->error;
+}
+
+/*!
+  Returns \e true if a callback stopped parsing.
+*/
+
+bool
+dimePushParser::isAborted() const
+{
+  return this->aborted;
+}
+
+/*!
+  Returns \e true if the data is a binary DXF file. Only valid after
+  the first 24 bytes have been fed.
+*/
+
+bool
+dimePushParser::isBinary() const
+{
+  return this->binary;
+}
+
+/*!
+  Returns the name of the section being parsed, or an empty string
+  between sections.
+*/
+
+const char *
+dimePushParser::getSectionName() const
+{
+  return this->section;
+}
+
+/*!
+  Returns the line number (ASCII) or byte offset (binary) of the data
+  parsed so far, excluding data kept for the next call to feed().
+*/
+
+int64
+dimePushParser::getFilePosition() const
+{
+  return this->position;
+}
+
+/*!
+  Returns the model containing the sections read so far, except the
+  BLOCKS and ENTITIES sections. Layers, handles and block names found
+  in the entities are registered here too.
+*/
+
+dimeModel *
+dimePushParser::getModel()
+{
+  return &this->model;
+}
+
+/*!
+  \overload
+*/
+
+const dimeModel *
+dimePushParser::getModel() const
+{
+  return &this->model;
+}
+
+//
+// Handles all complete records in the buffer. Returns false on
+// errors, or if a callback stopped parsing.
+//
+
+bool
+dimePushParser::parse()
+{
+  int32 code;
+  const char *value;
+  int len;
+  size_t codeend;
+  while (this->state != DIME_PUSH_DONE) {
+    size_t start = this->scanPos;
+    int ret = this->nextRecord(code, value, len, codeend);
+    if (ret == 0) break;
+    if (ret < 0) {
+      fprintf(stderr, "Error reading groupcode at position: %lld\n",
+              (long long) this->recordPosition);
+      this->error = true;
+      break;
+    }
+    if (!this->handleRecord(code, value, len, start, codeend)) break;
+  }
+  return !this->error && !this->aborted;
+}
+
+//
+// Checks whether the data is a binary file, like
+// dimeInput::checkBinary(). Returns false if more data is needed
+// to tell, unless \a final is set.
+//
+
+bool
+dimePushParser::checkEncoding(const bool final)
+{
+  static const char binaryid[] = "AutoCAD Binary DXF";
+  size_t n = this->bufferLen - this->scanPos;
+  size_t idlen = sizeof(binaryid) - 1;
+  const char *p = this->buffer + this->scanPos;
+  if (memcmp(p, binaryid, n < idlen ? n : idlen) || final) {
+    this->binary = false;
+    this->state = DIME_PUSH_TOPLEVEL;
+    return true;
+  }
+  // the sentinel, and the first group code to tell 8 from 16 bits
+  if (n < HEADROOM + 2) return false;
+  memcpy(this->header, p, HEADROOM);
+  this->binary = true;
+  this->binary16bit = p[HEADROOM + 1] == 0;
+  this->scanPos += HEADROOM;
+  this->position = HEADROOM;
+  this->state = DIME_PUSH_TOPLEVEL;
+  return true;
+}
+
+//
+// Finds the next record in the buffer. Returns 1 and its group code
+// in \a code, the value in \a value and \a len (only for strings),
+// and the offset just after the group code in \a codeend if it is
+// complete, 0 if more data is needed, and -1 on errors.
+//
+
+int
+dimePushParser::nextRecord(int32 &code, const char *&value, int &len,
+                           size_t &codeend)
+{
+  this->recordPosition = this->position;
+  return this->binary ? this->nextRecordBinary(code, value, len, codeend) :
+    this->nextRecordAscii(code, value, len, codeend);
+}
+
+//
+// See nextRecord().
+//
+
+int
+dimePushParser::nextRecordAscii(int32 &code, const char *&value, int &len,
+                                size_t &codeend)
+{
+  const char *p = this->buffer + this->scanPos;
+  const char *end = this->buffer + this->bufferLen;
+  const char *valstart, *next;
+  const char *codelineend = dime_lineend(p, end, valstart);
+  if (codelineend == NULL) return 0;
+  const char *vallineend = dime_lineend(valstart, end, next);
+  if (vallineend == NULL) return 0;
+
+  long val;
+  if (!dime_parse_integer(p, codelineend, val)) return -1;
+  code = (int32) val;
+
+  while (valstart < vallineend && (*valstart == ' ' || *valstart == '\t')) {
+    valstart++;
+  }
+  while (vallineend > valstart && (vallineend[-1] == ' ' ||
+                                   vallineend[-1] == '\t')) {
+    vallineend--;
+  }
+  value = valstart;
+  len = (int) (vallineend - valstart);
+  codeend = valstart - this->buffer;
+  this->scanPos = next - this->buffer;
+  this->position += 2;
+  return 1;
+}
+
+//
+// See nextRecord().
+//
+
+int
+dimePushParser::nextRecordBinary(int32 &code, const char *&value, int &len,
+                                 size_t &codeend)
+{
+  const unsigned char *p =
+    (const unsigned char*) this->buffer + this->scanPos;
+  const unsigned char *end =
+    (const unsigned char*) this->buffer + this->bufferLen;
+  // binary files are little endian
+  if (this->binary16bit) {
+    if (end - p < 2) return 0;
+    code = (int32) (uint16) (p[0] | (p[1] << 8));
+    p += 2;
+  }
+  else {
+    if (end - p < 1) return 0;
+    code = (int32) *p++;
+    if (code == 255) {
+      if (end - p < 2) return 0;
+      code = (int32) (int16) (p[0] | (p[1] << 8));
+      p += 2;
+    }
+  }
+  codeend = (const char*) p - this->buffer;
+
+  int size;
+  switch (dimeRecord::getRecordType(code)) {
+  case dimeBase::dimeInt8RecordType:
+    size = 1;
+    break;
+  case dimeBase::dimeInt16RecordType:
+    size = 2;
+    break;
+  case dimeBase::dimeInt32RecordType:
+    size = 4;
+    break;
+  case dimeBase::dimeFloatRecordType:
+  case dimeBase::dimeDoubleRecordType:
+    size = 8; // binary files only contains doubles
+    break;
+  default: {
+    const unsigned char *zero =
+      (const unsigned char*) memchr(p, 0, end - p);
+    if (zero == NULL) return 0;
+    value = (const char*) p;
+    len = (int) (zero - p);
+    size = len + 1;
+    break;
+  }
+  }
+  if (end - p < size) return 0;
+  p += size;
+  size_t next = (const char*) p - this->buffer;
+  this->position += (int64) (next - this->scanPos);
+  this->scanPos = next;
+  return 1;
+}
+
+//
+// Handles the record with group code \a code and value \a value,
+// which starts at offset \a start in the buffer. Returns false on
+// errors, or if a callback stopped parsing.
+//
+
+bool
+dimePushParser::handleRecord(const int32 code, const char * const value,
+                             const int len, const size_t start,
+                             const size_t codeend)
+{
+  if (code == 999) return true; // comments are skipped by dimeInput too
+  switch (this->state) {
+  case DIME_PUSH_TOPLEVEL:
+    if (code == 0 && dime_push_match(value, len, "SECTION")) {
+      // the section records are read with the section
+      this->unitStart = start;
+      this->unitPosition = this->recordPosition;
+      this->state = DIME_PUSH_SECTIONNAME;
+      return true;
+    }
+    if (code == 0 && dime_push_match(value, len, "EOF")) {
+      this->unitStart = 0;
+      this->state = DIME_PUSH_DONE;
+      return true;
+    }
+    break;
+
+  case DIME_PUSH_SECTIONNAME: {
+    if (code != 2) break;
+    int n = len < (int) sizeof(this->section) - 1 ?
+      len : (int) sizeof(this->section) - 1;
+    memcpy(this->section, value, n);
+    this->section[n] = '\0';
+    if (dime_push_match(value, len, "BLOCKS") ||
+        dime_push_match(value, len, "ENTITIES")) {
+      this->unitStart = 0;
+      this->state = DIME_PUSH_ENTITIES;
+    }
+    else this->state = DIME_PUSH_SECTION;
+    if (this->sectionCallback &&
+        !this->sectionCallback(this->section, true, this->sectionData)) {
+      this->aborted = true;
+      return false;
+    }
+    return true;
+  }
+
+  case DIME_PUSH_SECTION:
+    if (code != 0 || !dime_push_match(value, len, "ENDSEC")) return true;
+    if (!this->readUnit(this->scanPos) || !this->readSection()) {
+      return false;
+    }
+    this->unitStart = 0;
+    this->state = DIME_PUSH_TOPLEVEL;
+    if (this->sectionCallback &&
+        !this->sectionCallback(this->section, false, this->sectionData)) {
+      this->aborted = true;
+    }
+    this->section[0] = '\0';
+    return !this->aborted;
+
+  case DIME_PUSH_ENTITIES:
+    if (code != 0) {
+      if (this->unitStart) return true;
+      break;
+    }
+    if (this->unitStart) {
+      // the children of an entity, and the entities of a block, are
+      // read with it
+      if (this->unitIsBlock) {
+        if (dime_push_match(value, len, "ENDBLK")) this->unitIsBlock = false;
+        return true;
+      }
+      if (dime_push_match(value, len, "VERTEX") ||
+          dime_push_match(value, len, "ATTRIB") ||
+          dime_push_match(value, len, "SEQEND")) return true;
+      // the entity is read up to and including this group code
+      if (!this->readUnit(codeend) || !this->readEntity()) return false;
+      this->unitStart = 0;
+    }
+    if (dime_push_match(value, len, "ENDSEC")) {
+      this->state = DIME_PUSH_TOPLEVEL;
+      if (this->sectionCallback &&
+          !this->sectionCallback(this->section, false, this->sectionData)) {
+        this->aborted = true;
+      }
+      this->section[0] = '\0';
+      return !this->aborted;
+    }
+    this->unitStart = start;
+    this->unitPosition = this->recordPosition;
+    this->unitIsBlock = dime_push_match(value, len, "BLOCK");
+    return true;
+
+  default:
+    break;
+  }
+  fprintf(stderr, "Unexpected record at position: %lld\n",
+          (long long) this->recordPosition);
+  this->error = true;
+  return false;
+}
+
+//
+// Prepares for reading the current unit, which ends at offset \a end
+// in the buffer.
+//
+
+bool
+dimePushParser::readUnit(const size_t end)
+{
+  const char *data = this->buffer + this->unitStart;
+  if (this->binary) {
+    // the data in front of the unit has been read, replace it with
+    // the sentinel so that the unit is read as a binary file
+    data -= HEADROOM;
+    memcpy((char*) data, this->header, HEADROOM);
+  }
+  if (!this->input.setBuffer(data, this->buffer + end - data)) {
+    this->error = true;
+    return false;
+  }
+  return true;
+}
+
+//
+// Reads the entity in the input, and passes it to the entity callback.
+//
+
+bool
+dimePushParser::readEntity()
+{
+  int32 groupcode;
+  const char *string = NULL;
+  dimeInput *in = &this->input;
+  in->memhandler = this->memhandler;
+  bool ok = in->readGroupCode(groupcode) && groupcode == 0 &&
+    (string = in->readString()) != NULL;
+  if (ok) {
+    this->entity = dimeEntity::createEntity(string, this->memhandler);
+    ok = this->entity != NULL && this->entity->read(in);
+  }
+  if (!ok) {
+    fprintf(stderr, "error reading entity at position: %lld.\n",
+            (long long) this->unitPosition);
+    this->recycle();
+    this->error = true;
+    return false;
+  }
+  if (this->entityCallback &&
+      !this->entityCallback(this->section, this->entity, this->entityData)) {
+    this->aborted = true;
+  }
+  this->recycle();
+  return !this->aborted;
+}
+
+//
+// Reads the section in the input into the model.
+//
+
+bool
+dimePushParser::readSection()
+{
+  int32 groupcode;
+  const char *string = NULL;
+  dimeInput *in = &this->input;
+  in->memhandler = NULL;
+  bool ok = in->readGroupCode(groupcode) && groupcode == 0 &&
+    in->readString() != NULL && in->readGroupCode(groupcode) &&
+    groupcode == 2 && (string = in->readString()) != NULL;
+  dimeSection *sect = NULL;
+  if (ok) {
+    sect = dimeSection::createSection(string, in->getMemHandler());
+    ok = sect != NULL && sect->read(in);
+  }
+  if (!ok) {
+    fprintf(stderr, "error reading section at position: %lld.\n",
+            (long long) this->unitPosition);
+    delete sect;
+    this->error = true;
+    return false;
+  }
+  this->model.insertSection(sect);
+  return true;
+}
+
+//
+// Frees the last entity passed to the entity callback, see
+// dimeEntityStream::recycle().
+//
+
+void
+dimePushParser::recycle()
+{
+  if (this->entity) {
+    if (this->entity->typeId() == dimeBase::dimeBlockType) {
+      dimeBlock *block = (dimeBlock*)this->entity;
+      if (block->name) this->model.addReference(block->name, NULL);
+    }
+    this->entity->releaseMemory();
+    this->entity = NULL;
+    this->memhandler->reset();
+  }
+}
+
+//
+// Moves the data still needed to the front of the buffer.
+//
+
+void
+dimePushParser::compact()
+{
+  size_t keep = this->unitStart ? this->unitStart : this->scanPos;
+  if (keep <= HEADROOM) return;
+  size_t n = keep - HEADROOM;
+  memmove(this->buffer + HEADROOM, this->buffer + keep,
+          this->bufferLen - keep);
+  this->bufferLen -= n;
+  this->scanPos -= n;
+  if (this->unitStart) this->unitStart -= n;
+}
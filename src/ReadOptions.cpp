@@ -0,0 +1,260 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+/*!
+  \class dimeReadOptions dime/ReadOptions.h
+  \brief The dimeReadOptions class specifies which parts of a file
+  dimeModel::read() should load.
+
+  By default everything is loaded. Once a section, entity or layer
+  name has been added with keepSection(), keepEntity() or keepLayer(),
+  only sections, entities or layers with the names added are loaded.
+  The rest of the file is skipped without creating any entities or
+  records, which is a lot faster than reading everything when only
+  a small part of the file is needed.
+
+  The entity filter applies to the ENTITIES section and to the
+  entities in blocks. The layer filter only applies to the ENTITIES
+  section, since entities in blocks normally inherit the layer of the
+  INSERT entity. BLOCK entities are always kept. VERTEX, ATTRIB and
+  SEQEND entities belong to the entity in front of them, and are
+  kept or skipped together with it.
+
+  \code
+  dimeReadOptions options;
+  options.keepSection("HEADER");
+  options.keepSection("ENTITIES");
+  options.keepEntity("LINE");
+  options.keepEntity("LWPOLYLINE");
+  options.keepLayer("ROADS");
+  model.read(&in, &options);
+  \endcode
+
+  With setLazyEntities(), the entities in the ENTITIES section are not
+  decoded while reading, see dimeEntitiesSection. With
+  setPackedRecords(), the records that entities and tables don't
+  handle themselves are stored compactly, see dimeRecordHolder. With
+  setBorrowStrings(), the strings of a memory mapped binary DXF file
+  are used where they are in the file instead of being copied.
+*/
+
+#include <dime/ReadOptions.h>
+#include <dime/util/Dict.h>
+
+/*!
+  Constructor. Everything is kept.
+*/
+
+dimeReadOptions::dimeReadOptions()
+  : sections( NULL ), entities( NULL ), layers( NULL ),
+    lazyEntities( false ), packedRecords( false ), borrowStrings( false )
+{
+}
+
+/*!
+  Destructor.
+*/
+
+dimeReadOptions::~dimeReadOptions()
+{
+  delete this->sections;
+  delete this->entities;
+  delete this->layers;
+}
+
+/*!
+  Adds \a sectionname to the sections to load. When no sections have
+  been added, all sections are loaded.
+*/
+
+void
+dimeReadOptions::keepSection(const char * const sectionname)
+{
+  if (this->sections == NULL) this->sections = new dimeDict(17);
+  this->sections->enter(sectionname, NULL);
+}
+
+/*!
+  Adds \a entityname, e.g. "LINE", to the entities to load. When no
+  entities have been added, all entities are loaded.
+*/
+
+void
+dimeReadOptions::keepEntity(const char * const entityname)
+{
+  if (this->entities == NULL) this->entities = new dimeDict(101);
+  this->entities->enter(entityname, NULL);
+}
+
+/*!
+  Adds \a layername to the layers of the entities to load. When no
+  layers have been added, entities on all layers are loaded. Entities
+  without a layer are on layer "0".
+*/
+
+void
+dimeReadOptions::keepLayer(const char * const layername)
+{
+  if (this->layers == NULL) this->layers = new dimeDict(101);
+  this->layers->enter(layername, NULL);
+}
+
+/*!
+  Returns \e true if the section \a sectionname should be loaded.
+*/
+
+bool
+dimeReadOptions::isSectionKept(const char * const sectionname) const
+{
+  return this->sections == NULL || this->sections->find(sectionname) != NULL;
+}
+
+/*!
+  Returns \e true if entities named \a entityname should be loaded.
+*/
+
+bool
+dimeReadOptions::isEntityKept(const char * const entityname) const
+{
+  return this->entities == NULL || this->entities->find(entityname) != NULL;
+}
+
+/*!
+  Returns \e true if entities on the layer \a layername should be
+  loaded.
+*/
+
+bool
+dimeReadOptions::isLayerKept(const char * const layername) const
+{
+  return this->layers == NULL || this->layers->find(layername) != NULL;
+}
+
+/*!
+  Returns \e true if only some entities are loaded.
+*/
+
+bool
+dimeReadOptions::filtersEntities() const
+{
+  return this->entities != NULL || this->layers != NULL;
+}
+
+/*!
+  Returns \e true if only entities on some layers are loaded.
+*/
+
+bool
+dimeReadOptions::filtersLayers() const
+{
+  return this->layers != NULL;
+}
+
+/*!
+  Sets whether the entities of the ENTITIES section should be decoded
+  on first access instead of while reading. This only works for
+  memory mapped input (see dimeInput::setFile()), other inputs are
+  read as usual. The default is \e false.
+
+  \sa dimeEntitiesSection::getEntity()
+*/
+
+void
+dimeReadOptions::setLazyEntities(const bool onoff)
+{
+  this->lazyEntities = onoff;
+}
+
+/*!
+  Returns whether the entities are decoded on first access.
+*/
+
+bool
+dimeReadOptions::getLazyEntities() const
+{
+  return this->lazyEntities;
+}
+
+/*!
+  Sets whether the records not handled by the entity or table they
+  belong to are stored in one packed block per object instead of as
+  dimeRecord objects. This uses a lot less memory for files with much
+  extended data. The records are converted to dimeRecord objects when
+  they are accessed through dimeRecordHolder::findRecord() or
+  modified.
+*/
+
+void
+dimeReadOptions::setPackedRecords(const bool onoff)
+{
+  this->packedRecords = onoff;
+}
+
+/*!
+  Returns whether unhandled records are stored packed.
+*/
+
+bool
+dimeReadOptions::getPackedRecords() const
+{
+  return this->packedRecords;
+}
+
+/*!
+  Sets whether the strings of the model should point into the input
+  data instead of being copied. This only works for binary DXF files
+  read from a memory mapped file or from memory (see
+  dimeInput::setBuffer()), by a model using a memory handler, as the
+  strings must be zero terminated in the input. The model keeps the
+  mapping of the file until it is deleted. Data given to setBuffer()
+  without copying it must be kept by the caller as long as the model.
+  The default is \e false.
+
+  ASCII files end their strings with line terminators, and are always
+  copied.
+*/
+
+void
+dimeReadOptions::setBorrowStrings(const bool onoff)
+{
+  this->borrowStrings = onoff;
+}
+
+/*!
+  Returns whether strings are borrowed from the input.
+*/
+
+bool
+dimeReadOptions::getBorrowStrings() const
+{
+  return this->borrowStrings;
+}
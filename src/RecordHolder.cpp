@@ -39,6 +39,14 @@
   all of the reading, error checking and storing of records of no use to the
   subclass.  Subclasses will only need to implement the
   dimeRecordHolder::handleRecord() and dimeRecordHolder::getRecord() methods.
+
+  When the file is read with dimeReadOptions::setPackedRecords(), the
+  records not handled by the subclass are stored in one contiguous
+  block per record holder, instead of as one dimeRecord object each.
+  getRecord(), write(), countRecords() and copyRecords() use the block
+  directly. The records are converted to dimeRecord objects when they
+  are accessed through findRecord() or getRecordInRecordHolder(), or
+  when records are set.
 */
 
 #include <dime/RecordHolder.h>
@@ -46,6 +54,86 @@
 #include <dime/Output.h>
 #include <dime/util/MemHandler.h>
 #include <dime/records/Record.h>
+#include <dime/ReadOptions.h>
+#include "InputReader.h"
+
+//
+// A block of packed records starts with this header, followed by the
+// records. Each record is a dime_packed_record, directly followed by
+// the string for string records, padded to keep the records aligned.
+//
+
+struct dime_packed_header {
+  dimeMemHandler *memhandler; // the block was allocated from this
+  int size;                   // bytes, including the header
+};
+
+struct dime_packed_record {
+  int32 groupcode;
+  int32 size;                 // bytes, including the string
+  dimeParam value;            // not used for strings
+};
+
+#define DIME_PACKED_ALIGN 8
+
+static inline const dime_packed_record *
+dime_packed_first(const char * const block)
+{
+  return (const dime_packed_record*) (block + sizeof(dime_packed_header));
+}
+
+static inline const dime_packed_record *
+dime_packed_next(const dime_packed_record * const rec)
+{
+  return (const dime_packed_record*) (((const char*) rec) + rec->size);
+}
+
+static inline void
+dime_packed_value(const dime_packed_record * const rec, dimeParam &param)
+{
+  // only string records have data after the record
+  if (rec->size > (int) sizeof(dime_packed_record))
+    param.string_data = (const char*) (rec + 1);
+  else param = rec->value;
+}
+
+//
+// Returns the field in \a fields with group code \a groupcode, or NULL.
+// The tables are small, and sorted with the most common group codes
+// first, so a linear search is fine.
+//
+
+static inline const dimeRecordField *
+dime_find_field(const dimeRecordField *fields, const int groupcode)
+{
+  for (; fields->groupcode; fields++) {
+    if (fields->groupcode == groupcode) return fields;
+  }
+  return NULL;
+}
+
+//
+// Reads the value for \a field directly into the member of \a holder.
+//
+
+template <int encoding>
+static inline bool
+dime_read_field(dimeInput * const file, const dimeRecordField * const field,
+                dimeRecordHolder * const holder)
+{
+  void *member = field->member(holder);
+  switch (field->type) {
+  case dimeBase::dimeDoubleRecordType:
+    return dimeReader<encoding>::readDouble(file, *(dxfdouble*) member);
+  case dimeBase::dimeInt16RecordType:
+    return dimeReader<encoding>::readInt16(file, *(int16*) member);
+  case dimeBase::dimeInt32RecordType:
+    return dimeReader<encoding>::readInt32(file, *(int32*) member);
+  default:
+    assert(0);
+    return false;
+  }
+}
 
 /*!
   Constructor. \a separator is the group code that will separate objects,
@@ -55,7 +143,7 @@
 */
 
 dimeRecordHolder::dimeRecordHolder(const int sep)
-  : records( NULL ), numRecords( 0 )
+  : records( NULL ), numRecords( 0 ), packedRecords( NULL )
 {
   if (sep) assert(false);
   // this->separator = sep;
@@ -68,8 +156,10 @@ dimeRecordHolder::dimeRecordHolder(const int sep)
 dimeRecordHolder::~dimeRecordHolder()
 {
   int i, n = this->numRecords;
+  if (this->packedRecords) n = 0;
   for (i = 0; i < n; i++) delete this->records[i];
   delete [] records;
+  delete [] this->packedRecords;
 }
 
 //!
@@ -90,7 +180,21 @@ dimeRecordHolder::copyRecords(dimeRecordHolder * const rh,
                              dimeMemHandler * const memh) const
 {
   bool ok = true;
-  if (this->numRecords) {
+  rh->packedRecords = NULL;
+  if (this->packedRecords) {
+    int size = ((const dime_packed_header*) this->packedRecords)->size;
+    char *block = memh ? (char*) memh->allocMem(size, DIME_PACKED_ALIGN) :
+      new char[size];
+    if (block) {
+      memcpy(block, this->packedRecords, size);
+      ((dime_packed_header*) block)->memhandler = memh;
+      rh->packedRecords = block;
+      rh->records = NULL;
+      rh->numRecords = this->numRecords;
+    }
+    else ok = false;
+  }
+  else if (this->numRecords) {
     rh->records = ARRAY_NEW(memh, dimeRecord*, this->numRecords);
     if (rh->records) {
       rh->numRecords = this->numRecords;
@@ -118,15 +222,44 @@ dimeRecordHolder::copyRecords(dimeRecordHolder * const rh,
 bool 
 dimeRecordHolder::read(dimeInput * const file)
 {
-  
+  // the encoding is tested once per object, and the records are read
+  // with the reader for it, instead of through dimeInput's reader
+  // table for every group code and value
+  const bool packed = file->options && file->options->getPackedRecords();
+  switch (file->reader->encoding) {
+  case DIME_ENCODING_BINARY:
+    return packed ? this->readPacked<DIME_ENCODING_BINARY>(file) :
+      this->readRecords<DIME_ENCODING_BINARY>(file);
+  case DIME_ENCODING_SWAPPED:
+    return packed ? this->readPacked<DIME_ENCODING_SWAPPED>(file) :
+      this->readRecords<DIME_ENCODING_SWAPPED>(file);
+  default:
+    return packed ? this->readPacked<DIME_ENCODING_ASCII>(file) :
+      this->readRecords<DIME_ENCODING_ASCII>(file);
+  }
+}
+
+//
+// Reads the records of the object with the reader for \a encoding.
+// The records not handled by the subclass are collected in the
+// input's recordBuf.
+//
+
+template <int encoding>
+bool
+dimeRecordHolder::readRecords(dimeInput * const file)
+{
   dimeRecord *record;
   bool ok = true;
   int32 groupcode;
-  dimeArray <dimeRecord*> array(256); // temporary array
+  // the array is reused for every object read from file
+  dimeArray <dimeRecord*> &array = file->recordBuf;
+  const int start = array.count();
   dimeMemHandler *memhandler = file->getMemHandler();
+  const dimeRecordField *fields = this->getFields();
 
   while (true) {
-    if (!file->readGroupCode(groupcode)) {
+    if (!dimeReader<encoding>::readGroupCode(file, groupcode)) {
       ok = false;
       break;
     }
@@ -134,9 +267,19 @@ dimeRecordHolder::read(dimeInput * const file)
       file->putBackGroupCode(groupcode);
       break;
     }
+    const dimeRecordField *field =
+      fields ? dime_find_field(fields, groupcode) : NULL;
+    if (field) {
+      assert(field->type == dimeRecord::getRecordType(groupcode));
+      ok = dime_read_field<encoding>(file, field, this);
+      if (!ok) {
+        fprintf( stderr, "Unable to read record data for groupcode: %d\n",groupcode);
+        break;
+      }
+    }
     else { // check if subclass will handle this record
       dimeParam param;
-      ok = dimeRecord::readRecordData(file, groupcode, param);
+      ok = dimeReader<encoding>::readRecordData(file, groupcode, param);
       if (!ok) {
         fprintf( stderr, "Unable to read record data for groupcode: %d\n",groupcode);
 //	sim_warning("Unable to read record data for groupcode: %d\n",
@@ -156,17 +299,134 @@ dimeRecordHolder::read(dimeInput * const file)
       }
     }
   }
-  int num = array.count();
+  int num = array.count() - start;
   if (ok && num) {
     this->records = ARRAY_NEW(memhandler, dimeRecord*, num);
     this->numRecords = num;
     for (int i = 0; i < num; i++) {
-      this->records[i] = array[i];
+      this->records[i] = array[start + i];
     }
   }  
+  array.setCount(start);
   return ok;  
 }
 
+//
+// Like read(), but stores the records in a packed block. The records
+// are collected in the input's packBuf first, and copied to a block
+// of the right size at the end.
+//
+
+template <int encoding>
+bool
+dimeRecordHolder::readPacked(dimeInput * const file)
+{
+  bool ok = true;
+  int32 groupcode;
+  dimeArray <char> &buf = file->packBuf;
+  const int start = buf.count();
+  int pos = start + (int) sizeof(dime_packed_header);
+  int num = 0;
+  dimeMemHandler *memhandler = file->getMemHandler();
+  const dimeRecordField *fields = this->getFields();
+
+  while (true) {
+    if (!dimeReader<encoding>::readGroupCode(file, groupcode)) {
+      ok = false;
+      break;
+    }
+    if (groupcode == 0) {
+      file->putBackGroupCode(groupcode);
+      break;
+    }
+    const dimeRecordField *field =
+      fields ? dime_find_field(fields, groupcode) : NULL;
+    if (field) {
+      assert(field->type == dimeRecord::getRecordType(groupcode));
+      ok = dime_read_field<encoding>(file, field, this);
+      if (!ok) {
+        fprintf( stderr, "Unable to read record data for groupcode: %d\n",groupcode);
+        break;
+      }
+      continue;
+    }
+    dimeParam param;
+    ok = dimeReader<encoding>::readRecordData(file, groupcode, param);
+    if (!ok) {
+      fprintf( stderr, "Unable to read record data for groupcode: %d\n",groupcode);
+      break;
+    }
+    if (!this->handleRecord(groupcode, param, memhandler)) {
+      int type = dimeRecord::getRecordType(groupcode);
+      int len = 0;
+      if (type == dimeBase::dimeStringRecordType ||
+          type == dimeBase::dimeHexRecordType) {
+        len = (int) strlen(param.string_data) + 1;
+      }
+      int size = (int) sizeof(dime_packed_record) +
+        ((len + DIME_PACKED_ALIGN - 1) & ~(DIME_PACKED_ALIGN - 1));
+      buf[pos + size - 1] = 0; // grows the array
+      dime_packed_record rec;
+      rec.groupcode = groupcode;
+      rec.size = size;
+      if (len) memset(&rec.value, 0, sizeof(rec.value));
+      else rec.value = param;
+      char *ptr = buf.arrayPointer() + pos;
+      memcpy(ptr, &rec, sizeof(rec));
+      if (len) {
+        memcpy(ptr + sizeof(rec), param.string_data, len);
+        memset(ptr + sizeof(rec) + len, 0, size - sizeof(rec) - len);
+      }
+      pos += size;
+      num++;
+    }
+  }
+  if (ok && num) {
+    int size = pos - start;
+    char *block = memhandler ?
+      (char*) memhandler->allocMem(size, DIME_PACKED_ALIGN) : new char[size];
+    if (block) {
+      dime_packed_header header;
+      header.memhandler = memhandler;
+      header.size = size;
+      memcpy(block, &header, sizeof(header));
+      memcpy(block + sizeof(header), 
+             buf.arrayPointer() + start + sizeof(header),
+             size - sizeof(header));
+      this->packedRecords = block;
+      this->records = NULL;
+      this->numRecords = num;
+    }
+    else ok = false;
+  }
+  buf.setCount(start);
+  return ok;
+}
+
+//
+// Converts packed records to dimeRecord objects, allocated the same
+// way as the packed block was.
+//
+
+void
+dimeRecordHolder::unpackRecords()
+{
+  if (!this->packedRecords) return;
+  dimeMemHandler *memhandler =
+    ((const dime_packed_header*) this->packedRecords)->memhandler;
+  dimeRecord **array = ARRAY_NEW(memhandler, dimeRecord*, this->numRecords);
+  const dime_packed_record *rec = dime_packed_first(this->packedRecords);
+  for (int i = 0; i < this->numRecords; i++) {
+    dimeParam param;
+    dime_packed_value(rec, param);
+    array[i] = dimeRecord::createRecord(rec->groupcode, param, memhandler);
+    rec = dime_packed_next(rec);
+  }
+  if (!memhandler) delete [] this->packedRecords;
+  this->packedRecords = NULL;
+  this->records = array;
+}
+
 /*!
   Will write the records to \a file.
 */
@@ -174,6 +434,20 @@ dimeRecordHolder::read(dimeInput * const file)
 bool
 dimeRecordHolder::write(dimeOutput * const file)
 {
+  if (this->packedRecords) {
+    const dime_packed_record *rec = dime_packed_first(this->packedRecords);
+    for (int i = 0; i < this->numRecords; i++) {
+      if (this->shouldWriteRecord(rec->groupcode)) {
+        dimeParam param;
+        dime_packed_value(rec, param);
+        if (!file->writeGroupCode(rec->groupcode) ||
+            !dimeRecord::writeRecordData(file, rec->groupcode, param))
+          return false;
+      }
+      rec = dime_packed_next(rec);
+    }
+    return true;
+  }
   int i, n = this->numRecords;
   for (i = 0; i < n; i++) {
     if (this->shouldWriteRecord(this->records[i]->getGroupCode())) {
@@ -208,6 +482,28 @@ dimeRecordHolder::handleRecord(const int,
   return false;
 }
 
+/*!
+  Can be overloaded by subclasses that store some of their records as
+  plain numeric members. The returned table, terminated by an entry with
+  group code 0, is used by dimeRecordHolder::read() to read the values
+  for those group codes directly into the members, without calling
+  handleRecord(). Records with other group codes are still passed to
+  handleRecord(). Use DIME_RECORD_FIELD() to create the entries.
+
+  The table is only used for reading. handleRecord() must still handle
+  the group codes in the table, for dimeRecordHolder::setRecord(). A
+  subclass that changes how one of these group codes is handled in
+  handleRecord() must overload this method too.
+
+  Default method returns \e NULL.
+*/
+
+const dimeRecordField *
+dimeRecordHolder::getFields() const
+{
+  return NULL;
+}
+
 /*!
   Sets the data for the record with group code \a groupcode. If the
   record already exists, its value will simply be overwritten,
@@ -264,6 +560,17 @@ dimeRecordHolder::getRecord(const int groupcode,
 {
   int i, n = this->numRecords;
   int cnt = 0;
+  if (this->packedRecords) {
+    const dime_packed_record *rec = dime_packed_first(this->packedRecords);
+    for (i = 0; i < n; i++) {
+      if (rec->groupcode == groupcode && cnt++ == index) {
+        dime_packed_value(rec, param);
+        return true;
+      }
+      rec = dime_packed_next(rec);
+    }
+    return false;
+  }
   for (i = 0; i < n; i++) {
     if (this->records[i]->getGroupCode() == groupcode) {
       if (cnt++ == index) {
@@ -290,6 +597,7 @@ dimeRecordHolder::setRecords(const int * const groupcodes,
 {
   int i;
   dimeArray <dimeRecord*> newrecords(64);
+  this->unpackRecords();
 
   for (i = 0; i < numrecords; i++) {
     const int groupcode = groupcodes[i];
@@ -360,6 +668,7 @@ dimeRecordHolder::countRecords() const
 dimeRecord *
 dimeRecordHolder::findRecord(const int groupcode, const int index)
 {
+  this->unpackRecords();
   int i, n = this->numRecords;
   int cnt = 0;
   for (i = 0; i < n; i++) {
@@ -433,6 +742,7 @@ dimeRecordHolder::getNumRecordsInRecordHolder(void) const
 dimeRecord * 
 dimeRecordHolder::getRecordInRecordHolder(const int idx) const
 {
+  ((dimeRecordHolder*)this)->unpackRecords();
   assert(idx < this->numRecords);
   return this->records[idx];
 }
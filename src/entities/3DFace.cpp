@@ -125,6 +125,31 @@ dime3DFace::handleRecord(const int groupcode,
   }
 }
 
+const dimeRecordField dime3DFace::fields[] = {
+  DIME_RECORD_FIELD(10, dime3DFace, coords[0].x),
+  DIME_RECORD_FIELD(20, dime3DFace, coords[0].y),
+  DIME_RECORD_FIELD(30, dime3DFace, coords[0].z),
+  DIME_RECORD_FIELD(11, dime3DFace, coords[1].x),
+  DIME_RECORD_FIELD(21, dime3DFace, coords[1].y),
+  DIME_RECORD_FIELD(31, dime3DFace, coords[1].z),
+  DIME_RECORD_FIELD(12, dime3DFace, coords[2].x),
+  DIME_RECORD_FIELD(22, dime3DFace, coords[2].y),
+  DIME_RECORD_FIELD(32, dime3DFace, coords[2].z),
+  DIME_RECORD_FIELD(13, dime3DFace, coords[3].x),
+  DIME_RECORD_FIELD(23, dime3DFace, coords[3].y),
+  DIME_RECORD_FIELD(33, dime3DFace, coords[3].z),
+  DIME_RECORD_FIELD(70, dime3DFace, flags),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dime3DFace::getFields() const
+{
+  return dime3DFace::fields;
+}
+
 //!
 
 bool 
@@ -157,6 +157,28 @@ dimeArc::handleRecord(const int groupcode,
   return dimeExtrusionEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeArc::fields[] = {
+  DIME_RECORD_FIELD(10, dimeArc, center.x),
+  DIME_RECORD_FIELD(20, dimeArc, center.y),
+  DIME_RECORD_FIELD(30, dimeArc, center.z),
+  DIME_RECORD_FIELD(40, dimeArc, radius),
+  DIME_RECORD_FIELD(50, dimeArc, startAngle),
+  DIME_RECORD_FIELD(51, dimeArc, endAngle),
+  DIME_RECORD_FIELD(39, dimeArc, thickness),
+  DIME_RECORD_FIELD(210, dimeArc, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeArc, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeArc, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeArc::getFields() const
+{
+  return dimeArc::fields;
+}
+
 //!
 
 const char *
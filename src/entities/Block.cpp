@@ -110,6 +110,21 @@ dimeBlock::~dimeBlock()
   }
 }
 
+/*!
+  Releases the memory of the entities in the block, and frees the
+  array of entities, which is not allocated by the memory handler.
+*/
+
+void
+dimeBlock::releaseMemory()
+{
+  for (int i = 0; i < this->entities.count(); i++) {
+    this->entities[i]->releaseMemory();
+  }
+  if (this->endblock) this->endblock->releaseMemory();
+  this->entities.freeMemory();
+}
+
 //!
 
 dimeEntity *
@@ -277,6 +292,22 @@ dimeBlock::handleRecord(const int groupcode,
   return dimeEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeBlock::fields[] = {
+  DIME_RECORD_FIELD(10, dimeBlock, basePoint.x),
+  DIME_RECORD_FIELD(20, dimeBlock, basePoint.y),
+  DIME_RECORD_FIELD(30, dimeBlock, basePoint.z),
+  DIME_RECORD_FIELD(70, dimeBlock, flags),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeBlock::getFields() const
+{
+  return dimeBlock::fields;
+}
+
 //!
 
 const char *
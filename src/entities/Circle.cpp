@@ -138,6 +138,26 @@ dimeCircle::handleRecord(const int groupcode,
   return dimeExtrusionEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeCircle::fields[] = {
+  DIME_RECORD_FIELD(10, dimeCircle, center.x),
+  DIME_RECORD_FIELD(20, dimeCircle, center.y),
+  DIME_RECORD_FIELD(30, dimeCircle, center.z),
+  DIME_RECORD_FIELD(40, dimeCircle, radius),
+  DIME_RECORD_FIELD(39, dimeCircle, thickness),
+  DIME_RECORD_FIELD(210, dimeCircle, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeCircle, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeCircle, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeCircle::getFields() const
+{
+  return dimeCircle::fields;
+}
+
 //!
 
 const char *
@@ -220,6 +220,31 @@ dimeEllipse::handleRecord(const int groupcode,
   return dimeExtrusionEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeEllipse::fields[] = {
+  DIME_RECORD_FIELD(10, dimeEllipse, center.x),
+  DIME_RECORD_FIELD(20, dimeEllipse, center.y),
+  DIME_RECORD_FIELD(30, dimeEllipse, center.z),
+  DIME_RECORD_FIELD(11, dimeEllipse, majorAxisEndpoint.x),
+  DIME_RECORD_FIELD(21, dimeEllipse, majorAxisEndpoint.y),
+  DIME_RECORD_FIELD(31, dimeEllipse, majorAxisEndpoint.z),
+  DIME_RECORD_FIELD(40, dimeEllipse, ratio),
+  DIME_RECORD_FIELD(41, dimeEllipse, startParam),
+  DIME_RECORD_FIELD(42, dimeEllipse, endParam),
+  DIME_RECORD_FIELD(39, dimeEllipse, thickness),
+  DIME_RECORD_FIELD(210, dimeEllipse, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeEllipse, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeEllipse, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeEllipse::getFields() const
+{
+  return dimeEllipse::fields;
+}
+
 //!
 
 const char *
@@ -129,11 +129,16 @@
 #include <dime/records/Int16Record.h>
 #include <dime/Input.h>
 #include <dime/Output.h>
+#include <dime/ReadOptions.h>
 #include <dime/util/MemHandler.h>
+#include <dime/util/Dict.h>
+#include <dime/util/Registry.h>
 #include <dime/Model.h>
 
 #include <string.h>
 #include <ctype.h>
+#include <atomic>
+#include <thread>
 
 // misc defines
 #define TMP_BUFFER_LEN 1024
@@ -192,6 +197,22 @@ dimeEntity::~dimeEntity()
 {
 }
 
+/*!
+  Frees the memory held by the entity that was not allocated by the
+  memory handler the entity was created with. The destructors are not
+  called for entities allocated by a memory handler, so this is
+  called before the memory handler is reset, as is done by
+  dimeEntityStream and dimePushParser for every entity.
+
+  The entity can not be used after this call. The default
+  implementation does nothing.
+*/
+
+void
+dimeEntity::releaseMemory()
+{
+}
+
 /*!
   Copies the common and unclassified records.
 */
@@ -273,66 +294,92 @@ dimeEntity::write(dimeOutput * const file)
   return dimeRecordHolder::write(file);
 }
 
+//
+// Factories for the built-in entities.
+//
+
+template <class T> static dimeEntity *
+dime_create_entity(const char * const, dimeMemHandler * const memhandler)
+{
+  return new(memhandler) T;
+}
+
+static dimeEntity *
+dime_create_block(const char * const, dimeMemHandler * const memhandler)
+{
+  return new(memhandler) dimeBlock(memhandler);
+}
+
+static bool
+dime_register_entities(dimeRegistry<dimeEntityFactory*> &registry)
+{
+  registry.enter("3DFACE", dime_create_entity<dime3DFace>);
+  registry.enter("VERTEX", dime_create_entity<dimeVertex>);
+  registry.enter("POLYLINE", dime_create_entity<dimePolyline>);
+  registry.enter("LINE", dime_create_entity<dimeLine>);
+  registry.enter("MTEXT", dime_create_entity<dimeMText>);
+  registry.enter("TEXT", dime_create_entity<dimeText>);
+  registry.enter("INSERT", dime_create_entity<dimeInsert>);
+  registry.enter("BLOCK", dime_create_block);
+  registry.enter("SOLID", dime_create_entity<dimeSolid>);
+  registry.enter("TRACE", dime_create_entity<dimeTrace>);
+  registry.enter("POINT", dime_create_entity<dimePoint>);
+  registry.enter("CIRCLE", dime_create_entity<dimeCircle>);
+  registry.enter("LWPOLYLINE", dime_create_entity<dimeLWPolyline>);
+  registry.enter("SPLINE", dime_create_entity<dimeSpline>);
+  registry.enter("ELLIPSE", dime_create_entity<dimeEllipse>);
+  registry.enter("ARC", dime_create_entity<dimeArc>);
+  return true;
+}
+
+//
+// Returns the entity factories. The built-in entities are registered
+// on first use, which is thread safe.
+//
+
+static dimeRegistry<dimeEntityFactory*> &
+dime_entity_registry()
+{
+  static dimeRegistry<dimeEntityFactory*> registry;
+  static bool registered = dime_register_entities(registry);
+  (void) registered;
+  return registry;
+}
+
 /*!
-  Static function which creates an entity based on its name. 
+  Static function which creates an entity based on its name. Entities
+  with no registered factory are created as dimeUnknownEntity.
+
+  \sa registerEntity()
 */
 
 dimeEntity *
 dimeEntity::createEntity(const char * const name, 
 			 dimeMemHandler * const memhandler)
 {
-#ifndef NDEBUG
-  //fprintf(stderr,"Entity: %s\n", name);
-#endif
-
-  //
-  // TODO: optimize 
-  //
-  // right now, I just check for the most common (for 3D gfx)
-  // entities first.
-  //
-  // Could be quite easily solved by using a hash list with
-  // pointers to static methods that returns a new instance
-  // of the correct type.
-  //
-
-  if (!strcmp(name, "3DFACE"))
-    return new(memhandler) dime3DFace;
-  if (!strcmp(name, "VERTEX"))
-    return new(memhandler) dimeVertex;
-  if (!strcmp(name, "POLYLINE"))
-    return new(memhandler) dimePolyline;
-  if (!strcmp(name, "LINE"))
-    return new(memhandler) dimeLine;
-  //<< PWH
-  if (!strcmp(name, "MTEXT"))
-    return new(memhandler) dimeMText;
-  //>>
-  if (!strcmp(name, "TEXT"))
-    return new(memhandler) dimeText;
-  if (!strcmp(name, "INSERT"))
-    return new(memhandler) dimeInsert;
-  if (!strcmp(name, "BLOCK"))
-    return new(memhandler) dimeBlock(memhandler);
-  if (!strcmp(name, "SOLID"))
-    return new(memhandler) dimeSolid;   
-  if (!strcmp(name, "TRACE"))
-    return new(memhandler) dimeTrace;
-  if (!strcmp(name, "POINT"))
-    return new(memhandler) dimePoint;
-  if (!strcmp(name, "CIRCLE"))
-    return new(memhandler) dimeCircle;
-  if (!strcmp(name, "LWPOLYLINE"))
-    return new(memhandler) dimeLWPolyline;
-  if (!strcmp(name, "SPLINE"))
-    return new(memhandler) dimeSpline;
-  if (!strcmp(name, "ELLIPSE"))
-    return new(memhandler) dimeEllipse;
-  if (!strcmp(name, "ARC"))
-    return new(memhandler) dimeArc;
+  dimeEntityFactory *factory = dime_entity_registry().find(name);
+  if (factory) return factory(name, memhandler);
   return new(memhandler) dimeUnknownEntity(name, memhandler);
 }
 
+/*!
+  Registers \a factory to create entities named \a name, replacing
+  the factory of a built-in entity if there is one. Setting \a
+  factory to NULL makes the entities be read as dimeUnknownEntity.
+  The factory must allocate the entity with \a memhandler, see
+  the class documentation above.
+
+  Factories should be registered before any file is read, as the
+  registry is not locked when entities are created.
+*/
+
+void
+dimeEntity::registerEntity(const char * const name,
+                           dimeEntityFactory * const factory)
+{
+  dime_entity_registry().enter(name, factory);
+}
+
 /*!
   Static function that reads all entities until an entity of type
   \a stopat is found. Returns \e true if all entities were read OK.
@@ -350,6 +397,8 @@ dimeEntity::readEntities(dimeInput * const file,
   bool ok = true;
   dimeEntity *entity = NULL;
   dimeMemHandler *memhandler = file->getMemHandler();
+  bool inblock = !strcmp(stopat, "ENDBLK");
+  bool checklayer;
   
   while (true) {
     if (!file->readGroupCode(groupcode) || groupcode != 0) {
@@ -359,6 +408,13 @@ dimeEntity::readEntities(dimeInput * const file,
     }
     string = file->readString();
     if (!strcmp(string, stopat)) break;
+    if (dimeEntity::skipEntity(file, string, inblock, checklayer)) {
+      if (!file->skipRecords()) {
+        ok = false;
+        break;
+      }
+      continue;
+    }
     entity = dimeEntity::createEntity(string, memhandler);
     if (entity == NULL) {
       fprintf(stderr,"error creating entity: %s\n", string);
@@ -370,10 +426,303 @@ dimeEntity::readEntities(dimeInput * const file,
       ok = false;
       break;
     }
+    if (checklayer && !file->options->isLayerKept(entity->getLayerName())) {
+      if (!memhandler) delete entity;
+      continue;
+    }
     array.append(entity);
   }
   return ok;
 }
+/*!
+  Static function that reads all entities until the end of the
+  section, using the number of threads set with
+  dimeInput::setNumThreads(). The section is first scanned for
+  entity boundaries, and split into parts that are read in parallel.
+  The entities are appended to \a array in file order. When \a
+  boundary is \e NULL, the section is split in front of any entity
+  but VERTEX, ATTRIB and SEQEND (which belong to the entity in front
+  of them). Otherwise it is only split in front of entities named \a
+  boundary, and only such entities are read.
+
+  Layers, handles and block references are registered in the model
+  during the scan, in file order, so the model ends up the same as if
+  the entities had been read in sequence. If the parts can't be read,
+  the whole section is read again in sequence.
+
+  If \a file can't be split, this function works as readEntities()
+  with \a stopat set to "ENDSEC".
+*/
+
+bool 
+dimeEntity::readEntitiesParallel(dimeInput * const file,
+                                 dimeArray <dimeEntity*> &array,
+                                 const char * const boundary)
+{
+  if (!file->canSplit()) {
+    return dimeEntity::readEntities(file, array, "ENDSEC");
+  }
+
+  size_t begin = file->tell();
+  int64 beginpos = file->getFilePosition();
+  dimeArray <size_t> starts(1024);
+  dimeArray <size_t> ends(1024);
+  dimeArray <int64> positions(1024);
+  if (!dimeEntity::scanEntities(file, boundary, starts, ends, positions)) {
+    return false;
+  }
+  int n = starts.count();
+  if (n == 0) return true;
+
+  // split into parts of about the same size, a few more than the
+  // number of threads to even out the load
+  int numthreads = file->getNumThreads();
+  int numparts = numthreads * 4;
+  dimeArray <int> first(numparts + 1);
+  size_t size = ends[n] - starts[0];
+  int i = 0;
+  for (int k = 0; k < numparts && i < n; k++) {
+    first.append(i);
+    size_t limit = starts[0] + size / numparts * (k + 1);
+    i++;
+    while (i < n && starts[i] < limit) i++;
+  }
+  first.append(n);
+  numparts = first.count() - 1;
+  if (numthreads > numparts) numthreads = numparts;
+
+  dimeMemHandler *memhandler = file->getMemHandler();
+  dimeMemHandler **memhandlers = new dimeMemHandler*[numthreads];
+  for (i = 0; i < numthreads; i++) {
+    memhandlers[i] = memhandler ? new dimeMemHandler : NULL;
+    if (memhandler) memhandlers[i]->borrowStrings(memhandler);
+  }
+  dimeInput *parts = new dimeInput[numparts];
+  dimeArray <dimeEntity*> *results = new dimeArray <dimeEntity*>[numparts];
+  bool *ok = new bool[numparts];
+
+  std::atomic<int> next(0);
+  auto readparts = [&](dimeMemHandler * const mh) {
+    int k;
+    while ((k = next++) < numparts) {
+      dimeInput *in = &parts[k];
+      size_t end = ends[first[k+1]];
+      ok[k] = in->initPart(file, starts[first[k]], positions[first[k]], mh);
+      int32 groupcode;
+      bool checklayer = false;
+      // a part ends when the group code of the next part has been read
+      while (ok[k] && in->readGroupCode(groupcode) && groupcode == 0 &&
+             in->tell() < end) {
+        const char *string = in->readString();
+        dimeEntity *entity = NULL;
+        if (string && !boundary &&
+            dimeEntity::skipEntity(in, string, false, checklayer)) {
+          ok[k] = in->skipRecords();
+          continue;
+        }
+        if (string && (!boundary || !strcmp(string, boundary))) {
+          entity = dimeEntity::createEntity(string, mh);
+        }
+        if (entity == NULL || !entity->read(in)) ok[k] = false;
+        if (entity && checklayer &&
+            !in->options->isLayerKept(entity->getLayerName())) {
+          if (!mh) delete entity;
+          entity = NULL;
+        }
+        if (entity) results[k].append(entity);
+      }
+      ok[k] = ok[k] && in->tell() == end;
+    }
+  };
+
+  std::thread *threads = new std::thread[numthreads - 1];
+  for (i = 0; i < numthreads - 1; i++) {
+    threads[i] = std::thread(readparts, memhandlers[i + 1]);
+  }
+  readparts(memhandlers[0]);
+  for (i = 0; i < numthreads - 1; i++) threads[i].join();
+  delete [] threads;
+
+  bool allok = true;
+  for (i = 0; i < numparts; i++) allok = allok && ok[i];
+  
+  int k;
+  for (k = 0; k < numparts; k++) {
+    for (i = 0; i < results[k].count(); i++) {
+      if (allok) array.append(results[k][i]);
+      else if (!memhandler) delete results[k][i];
+    }
+  }
+  for (i = 0; i < numthreads; i++) {
+    // the entities refer to the memory handlers, keep them alive
+    if (allok && memhandlers[i]) memhandler->adopt(memhandlers[i]);
+    else delete memhandlers[i];
+  }
+  delete [] memhandlers;
+  delete [] parts;
+  delete [] results;
+  delete [] ok;
+
+  if (!allok) {
+    // probably a malformed file, let the sequential reader deal with it
+    dimeInput whole;
+    return whole.initPart(file, begin, beginpos, memhandler) &&
+      dimeEntity::readEntities(&whole, array, "ENDSEC");
+  }
+  return true;
+}
+
+//
+// Returns true if the entity \a name, which has just been read, is
+// not wanted according to the read options of \a file. If its layer
+// could not be determined in advance, \a checklayer is set, and the
+// layer must be checked after the entity has been read. Entities in
+// blocks are not filtered by layer.
+//
+
+bool
+dimeEntity::skipEntity(dimeInput * const file, const char * const name,
+                       const bool inblock, bool &checklayer)
+{
+  const dimeReadOptions *options = file->options;
+  checklayer = false;
+  if (options == NULL || !options->filtersEntities()) return false;
+  if (!strcmp(name, "VERTEX") || !strcmp(name, "ATTRIB") ||
+      !strcmp(name, "SEQEND")) {
+    // these belong to the entity in front of them
+    return file->skipChildren;
+  }
+  file->skipChildren = true;
+  if (!options->isEntityKept(name)) return true;
+  if (!inblock && options->filtersLayers()) {
+    char layername[TMP_BUFFER_LEN+1];
+    int found = file->peekLayer(layername, TMP_BUFFER_LEN+1);
+    if (found < 0) checklayer = true;
+    else if (!options->isLayerKept(found ? layername :
+                                   dimeLayer::getDefaultLayer()->getLayerName())) {
+      return true;
+    }
+  }
+  file->skipChildren = false;
+  return false;
+}
+
+//
+// Reads the rest of the section, recording the offsets where the
+// parts that can be read in parallel may start, and the offsets just
+// after the group code of each of them. The records which change the
+// model during reading are handled here instead. If \a names is not
+// NULL, the names (stored in \a namedict) and layers of the entities
+// at the offsets are recorded too, and entities not wanted according
+// to the read options are left out.
+//
+
+bool 
+dimeEntity::scanEntities(dimeInput * const file,
+                         const char * const boundary,
+                         dimeArray <size_t> &starts,
+                         dimeArray <size_t> &ends,
+                         dimeArray <int64> &positions,
+                         dimeDict * const namedict,
+                         dimeArray <const char*> * const names,
+                         dimeArray <const dimeLayer*> * const layers)
+{
+  dimeModel *model = file->getModel();
+  const dimeReadOptions *options = file->options;
+  if (options && !options->filtersEntities()) options = NULL;
+  char layername[TMP_BUFFER_LEN+1];
+  layername[0] = 0;
+  bool isref = false;
+  bool kept = true; // is the entity read, see skipEntity()
+  bool filterlayer = false;
+  bool ischild = false;
+  bool skipchildren = false;
+  bool first = true;
+  bool isboundary = false;
+  int32 groupcode;
+  dimeParam param;
+
+  while (true) {
+    size_t start = file->tell();
+    int64 position = file->getFilePosition();
+    if (!file->readGroupCode(groupcode)) return false;
+    if (groupcode != 0 && first) {
+      fprintf(stderr,"Error reading groupcode: %d\n", groupcode);
+      return false;
+    }
+    if (groupcode != 0 && groupcode != 8 && (groupcode != 2 || !isref)) {
+      // nothing interesting, don't waste time parsing it
+      if (!file->skipValue(groupcode)) return false;
+      continue;
+    }
+    if (groupcode != 0) {
+      if (!dimeRecord::readRecordData(file, groupcode, param)) return false;
+      if (groupcode == 8) {
+        // the layer is added after the entity is read, see read()
+        strncpy(layername, param.string_data, TMP_BUFFER_LEN);
+        layername[TMP_BUFFER_LEN] = 0;
+      }
+      else if (groupcode == 2 && isref && model) {
+        // block name of BLOCK or INSERT, see dimeInsert::read()
+        if (!model->findRefStringPtr(param.string_data)) {
+          model->addReference(param.string_data, NULL);
+        }
+      }
+      continue;
+    }
+    size_t end = file->tell();
+    if (kept && filterlayer) {
+      kept = options->isLayerKept(layername[0] ? layername :
+                                  dimeLayer::getDefaultLayer()->getLayerName());
+    }
+    const dimeLayer *layer = dimeLayer::getDefaultLayer();
+    if (kept && layername[0] && model) layer = model->addLayer(layername);
+    if (!ischild) skipchildren = !kept;
+    layername[0] = 0;
+    if (names && isboundary) {
+      if (kept) layers->append(layer);
+      else {
+        // not wanted, forget about it
+        int n = starts.count() - 1;
+        starts.setCount(n);
+        ends.setCount(n);
+        positions.setCount(n);
+        names->setCount(n);
+      }
+    }
+    
+    const char *string = file->readString();
+    if (string == NULL) return false;
+    if (!strcmp(string, "ENDSEC")) {
+      ends.append(end);
+      return true;
+    }
+    isref = !strcmp(string, "INSERT") || !strcmp(string, "BLOCK");
+    ischild = !strcmp(string, "VERTEX") || !strcmp(string, "ATTRIB") ||
+      !strcmp(string, "SEQEND");
+    filterlayer = false;
+    if (options == NULL) kept = true;
+    else if (ischild) kept = !skipchildren;
+    else if (boundary) {
+      kept = !strcmp(string, boundary) || !strcmp(string, "ENDBLK") ||
+        options->isEntityKept(string);
+    }
+    else {
+      kept = options->isEntityKept(string);
+      filterlayer = options->filtersLayers();
+    }
+    // the first part must start at the first entity, whatever it is
+    isboundary = first || (boundary ? !strcmp(string, boundary) : !ischild);
+    if (isboundary) {
+      starts.append(start);
+      ends.append(end);
+      positions.append(position);
+      if (names) names->append(namedict->enter(string, NULL));
+    }
+    first = false;
+  }
+}
+
 
 /*!
   Static function which copies all non-deleted entities from 
@@ -633,6 +982,7 @@ dimeEntity::read(dimeInput * const file)
 
   char tmpbuffer[TMP_BUFFER_LEN+1];
   tmpbuffer[0] = 0;
+  tmpbuffer[TMP_BUFFER_LEN] = 0; // strncpy() won't terminate long names
   const dimeLayer *tmplayer = this->layer;
   this->layer = (const dimeLayer*) tmpbuffer;
   this->entityFlags |= FLAG_TMP_BUFFER_SET;
@@ -676,7 +1026,11 @@ dimeEntity::handleRecord(const int groupcode,
     // as a temporary storage for the character string.
     // Checking flag just to be safe...
     if (this->entityFlags & FLAG_TMP_BUFFER_SET) {
-      strncpy((char*)this->layer, param.string_data, TMP_BUFFER_LEN);
+      // not strncpy(), which would pad all of the buffer with zeros
+      size_t len = strlen(param.string_data);
+      if (len > TMP_BUFFER_LEN) len = TMP_BUFFER_LEN;
+      memcpy((char*)this->layer, param.string_data, len);
+      ((char*)this->layer)[len] = '\0';
     }
     else assert(0);
     return true;
@@ -336,6 +336,33 @@ dimeInsert::handleRecord(const int groupcode,
   return dimeEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeInsert::fields[] = {
+  DIME_RECORD_FIELD(10, dimeInsert, insertionPoint.x),
+  DIME_RECORD_FIELD(20, dimeInsert, insertionPoint.y),
+  DIME_RECORD_FIELD(30, dimeInsert, insertionPoint.z),
+  DIME_RECORD_FIELD(41, dimeInsert, scale.x),
+  DIME_RECORD_FIELD(42, dimeInsert, scale.y),
+  DIME_RECORD_FIELD(43, dimeInsert, scale.z),
+  DIME_RECORD_FIELD(50, dimeInsert, rotAngle),
+  DIME_RECORD_FIELD(66, dimeInsert, attributesFollow),
+  DIME_RECORD_FIELD(70, dimeInsert, columnCount),
+  DIME_RECORD_FIELD(71, dimeInsert, rowCount),
+  DIME_RECORD_FIELD(44, dimeInsert, columnSpacing),
+  DIME_RECORD_FIELD(45, dimeInsert, rowSpacing),
+  DIME_RECORD_FIELD(210, dimeInsert, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeInsert, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeInsert, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeInsert::getFields() const
+{
+  return dimeInsert::fields;
+}
+
 //!
 
 const char *
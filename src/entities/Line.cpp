@@ -124,6 +124,28 @@ dimeLine::handleRecord(const int groupcode,
   return dimeExtrusionEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeLine::fields[] = {
+  DIME_RECORD_FIELD(10, dimeLine, coords[0].x),
+  DIME_RECORD_FIELD(20, dimeLine, coords[0].y),
+  DIME_RECORD_FIELD(30, dimeLine, coords[0].z),
+  DIME_RECORD_FIELD(11, dimeLine, coords[1].x),
+  DIME_RECORD_FIELD(21, dimeLine, coords[1].y),
+  DIME_RECORD_FIELD(31, dimeLine, coords[1].z),
+  DIME_RECORD_FIELD(39, dimeLine, thickness),
+  DIME_RECORD_FIELD(210, dimeLine, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeLine, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeLine, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeLine::getFields() const
+{
+  return dimeLine::fields;
+}
+
 //!
 
 const char *
@@ -117,6 +117,25 @@ dimePoint::handleRecord(const int groupcode,
   return dimeExtrusionEntity::handleRecord(groupcode, param, memhandler); 
 }
 
+const dimeRecordField dimePoint::fields[] = {
+  DIME_RECORD_FIELD(10, dimePoint, coords.x),
+  DIME_RECORD_FIELD(20, dimePoint, coords.y),
+  DIME_RECORD_FIELD(30, dimePoint, coords.z),
+  DIME_RECORD_FIELD(39, dimePoint, thickness),
+  DIME_RECORD_FIELD(210, dimePoint, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimePoint, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimePoint, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimePoint::getFields() const
+{
+  return dimePoint::fields;
+}
+
 //!
 
 const char *
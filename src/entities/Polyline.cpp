@@ -430,6 +430,31 @@ dimePolyline::handleRecord(const int groupcode,
   return dimeExtrusionEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimePolyline::fields[] = {
+  DIME_RECORD_FIELD(10, dimePolyline, elevation.x),
+  DIME_RECORD_FIELD(20, dimePolyline, elevation.y),
+  DIME_RECORD_FIELD(30, dimePolyline, elevation.z),
+  DIME_RECORD_FIELD(70, dimePolyline, flags),
+  DIME_RECORD_FIELD(71, dimePolyline, countM),
+  DIME_RECORD_FIELD(72, dimePolyline, countN),
+  DIME_RECORD_FIELD(73, dimePolyline, smoothCountM),
+  DIME_RECORD_FIELD(74, dimePolyline, smoothCountN),
+  DIME_RECORD_FIELD(75, dimePolyline, surfaceType),
+  DIME_RECORD_FIELD(39, dimePolyline, thickness),
+  DIME_RECORD_FIELD(210, dimePolyline, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimePolyline, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimePolyline, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimePolyline::getFields() const
+{
+  return dimePolyline::fields;
+}
+
 //!
 
 const char *
@@ -123,6 +123,34 @@ dimeSolid::handleRecord(const int groupcode,
   return dimeFaceEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeSolid::fields[] = {
+  DIME_RECORD_FIELD(10, dimeSolid, coords[0].x),
+  DIME_RECORD_FIELD(20, dimeSolid, coords[0].y),
+  DIME_RECORD_FIELD(30, dimeSolid, coords[0].z),
+  DIME_RECORD_FIELD(11, dimeSolid, coords[1].x),
+  DIME_RECORD_FIELD(21, dimeSolid, coords[1].y),
+  DIME_RECORD_FIELD(31, dimeSolid, coords[1].z),
+  DIME_RECORD_FIELD(12, dimeSolid, coords[2].x),
+  DIME_RECORD_FIELD(22, dimeSolid, coords[2].y),
+  DIME_RECORD_FIELD(32, dimeSolid, coords[2].z),
+  DIME_RECORD_FIELD(13, dimeSolid, coords[3].x),
+  DIME_RECORD_FIELD(23, dimeSolid, coords[3].y),
+  DIME_RECORD_FIELD(33, dimeSolid, coords[3].z),
+  DIME_RECORD_FIELD(39, dimeSolid, thickness),
+  DIME_RECORD_FIELD(210, dimeSolid, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeSolid, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeSolid, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeSolid::getFields() const
+{
+  return dimeSolid::fields;
+}
+
 //!
 
 const char *
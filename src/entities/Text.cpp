@@ -60,15 +60,14 @@ dimeText::dimeText()
 {
 }
 
-//!
+/*!
+  Sets the text string. If \a memhandler is not \e NULL, the string
+  is allocated with it, and is freed with the model.
+*/
 
-void dimeText::setTextString(const char* s)
+void dimeText::setTextString(const char* s, dimeMemHandler * const memhandler)
 {
-  size_t l;
-  l = strlen( s );
-  char* t = new char[l+1];
-  strcpy( t, s );
-  this->text = (char*) t;
+  DXF_STRCPY(memhandler, this->text, s);
 
   // Set new width.
   this->width = this->height * CHAR_ASP * strlen( this->text );
@@ -201,7 +200,7 @@ dimeText::handleRecord(const int groupcode,
 
   switch(groupcode) {
   case 1:
-    this->setTextString( param.string_data );
+    this->setTextString( param.string_data, memhandler );
     if( this->height != 0.0 ) 
       this->width = this->height * CHAR_ASP * strlen( this->text );
     if( wScale != 0.0 ) 
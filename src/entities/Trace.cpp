@@ -120,6 +120,34 @@ dimeTrace::handleRecord(const int groupcode, const dimeParam &param,
   return dimeFaceEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeTrace::fields[] = {
+  DIME_RECORD_FIELD(10, dimeTrace, coords[0].x),
+  DIME_RECORD_FIELD(20, dimeTrace, coords[0].y),
+  DIME_RECORD_FIELD(30, dimeTrace, coords[0].z),
+  DIME_RECORD_FIELD(11, dimeTrace, coords[1].x),
+  DIME_RECORD_FIELD(21, dimeTrace, coords[1].y),
+  DIME_RECORD_FIELD(31, dimeTrace, coords[1].z),
+  DIME_RECORD_FIELD(12, dimeTrace, coords[2].x),
+  DIME_RECORD_FIELD(22, dimeTrace, coords[2].y),
+  DIME_RECORD_FIELD(32, dimeTrace, coords[2].z),
+  DIME_RECORD_FIELD(13, dimeTrace, coords[3].x),
+  DIME_RECORD_FIELD(23, dimeTrace, coords[3].y),
+  DIME_RECORD_FIELD(33, dimeTrace, coords[3].z),
+  DIME_RECORD_FIELD(39, dimeTrace, thickness),
+  DIME_RECORD_FIELD(210, dimeTrace, extrusionDir.x),
+  DIME_RECORD_FIELD(220, dimeTrace, extrusionDir.y),
+  DIME_RECORD_FIELD(230, dimeTrace, extrusionDir.z),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeTrace::getFields() const
+{
+  return dimeTrace::fields;
+}
+
 //!
 
 const char *
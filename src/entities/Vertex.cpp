@@ -189,6 +189,27 @@ dimeVertex::handleRecord(const int groupcode,
   return dimeEntity::handleRecord(groupcode, param, memhandler);
 }
 
+const dimeRecordField dimeVertex::fields[] = {
+  DIME_RECORD_FIELD(10, dimeVertex, coords.x),
+  DIME_RECORD_FIELD(20, dimeVertex, coords.y),
+  DIME_RECORD_FIELD(30, dimeVertex, coords.z),
+  DIME_RECORD_FIELD(42, dimeVertex, bulge),
+  DIME_RECORD_FIELD(70, dimeVertex, flags),
+  DIME_RECORD_FIELD(71, dimeVertex, indices[0]),
+  DIME_RECORD_FIELD(72, dimeVertex, indices[1]),
+  DIME_RECORD_FIELD(73, dimeVertex, indices[2]),
+  DIME_RECORD_FIELD(74, dimeVertex, indices[3]),
+  { 0, 0, NULL }
+};
+
+//!
+
+const dimeRecordField *
+dimeVertex::getFields() const
+{
+  return dimeVertex::fields;
+}
+
 //!
 
 const char *
@@ -218,10 +218,10 @@ dimeRecord::createRecord(const int group_code,
 
 //
 // local function that returns the type based on the group code
-// used to build a look-up table
+// used to build a look-up table at compile time
 //
 
-static int 
+static constexpr int 
 get_record_type(const int group_code)
 {
   int type = dimeBase::dimeStringRecordType;
@@ -337,6 +337,26 @@ get_record_type(const int group_code)
   return type;
 }
 
+//
+// the look-up table used by getRecordType(). It is computed by the
+// compiler, so it is shared read-only between threads and needs
+// no initialization at run time.
+//
+
+#define DIME_NUM_GROUPCODES 1072
+
+struct dime_record_type_table {
+  unsigned char type[DIME_NUM_GROUPCODES];
+
+  constexpr dime_record_type_table() : type() {
+    for (int i = 0; i < DIME_NUM_GROUPCODES; i++) {
+      type[i] = (unsigned char) get_record_type(i);
+    }
+  }
+};
+
+static constexpr dime_record_type_table dime_record_types;
+
 /*!
   Static function that returns the record type based on
   the group code.
@@ -345,17 +365,9 @@ get_record_type(const int group_code)
 int 
 dimeRecord::getRecordType(const int group_code)
 {
-  static int first = 1;
-  static int translation[1072];
-  if (first) {
-    first = 0;
-    for (int i = 0; i < 1072; i++) {
-      translation[i] = get_record_type(i);
-    }
-  }
-  if (group_code < 0 || group_code >= 1072)
+  if (group_code < 0 || group_code >= DIME_NUM_GROUPCODES)
     return dimeBase::dimeStringRecordType;
-  else return translation[group_code];
+  else return dime_record_types.type[group_code];
 }
 
 /*!
@@ -367,43 +379,39 @@ bool
 dimeRecord::readRecordData(dimeInput * const in, const int group_code,
 			  dimeParam &param)
 {
-  bool ret;
-  int type = getRecordType(group_code);
-  
-  switch(type) {
+  // read by the reader for the encoding of the file, see
+  // dimeInput::checkBinary()
+  return in->readRecordData(group_code, param);
+}
+
+/*!
+  Writes the value \a param of a record with group code \a group_code
+  to \a out, like the write() method of the record would do after
+  writing the group code.
+*/
+
+bool
+dimeRecord::writeRecordData(dimeOutput * const out, const int group_code,
+                            const dimeParam &param)
+{
+  switch (getRecordType(group_code)) {
   case dimeBase::dimeInt8RecordType:
-    ret = in->readInt8(param.int8_data);
-    break;
+    return out->writeInt8(param.int8_data);
   case dimeBase::dimeInt16RecordType:
-    ret = in->readInt16(param.int16_data);
-    break;
+    return out->writeInt16(param.int16_data);
   case dimeBase::dimeInt32RecordType:
-    ret = in->readInt32(param.int32_data);
-    break;
+    return out->writeInt32(param.int32_data);
   case dimeBase::dimeFloatRecordType:
-    ret = in->readFloat(param.float_data);
-    break;
+    return out->writeFloat(param.float_data);
   case dimeBase::dimeDoubleRecordType:
-    ret = in->readDouble(param.double_data);
-    break;
+    return out->writeDouble(param.double_data);
   case dimeBase::dimeStringRecordType:
-    if( group_code == 1 ) {
-      param.string_data = in->readStringNoSkip();
-    }
-    else {
-      param.string_data = in->readString();
-    }
-    ret = param.string_data != NULL;
-    break;
+    return out->writeString(param.string_data);
   case dimeBase::dimeHexRecordType:
-    param.hex_data = in->readString();
-    ret = param.hex_data != NULL;
-    break;
+    return out->writeString(param.hex_data);
   default:
     assert(0);
-    ret = false;
-    break;
+    return false;
   }
-  return ret;
 }
 
@@ -92,6 +92,20 @@ dimeBlocksSection::read(dimeInput * const file)
   dimeBlock *block = NULL;
   dimeMemHandler *memhandler = file->getMemHandler();
 
+  if (file->getNumThreads() > 1) {
+    dimeArray <dimeEntity*> array(1024);
+    ok = dimeEntity::readEntitiesParallel(file, array, "BLOCK");
+    for (int i = 0; ok && i < array.count(); i++) {
+      if (array[i]->typeId() != dimeBase::dimeBlockType) {
+        fprintf( stderr, "Unexpected string.\n");
+        ok = false;
+        break;
+      }
+      this->blocks.append((dimeBlock*)array[i]);
+    }
+    return ok;
+  }
+
   while (true) {
     if (!file->readGroupCode(groupcode) || groupcode != 0) {
       fprintf( stderr, "Error reading groupcode: %d\n", groupcode);
@@ -33,12 +33,25 @@
 /*!
   \class dimeEntitiesSection dime/sections/EntitiesSection.h
   \brief The dimeEntitiesSection class handles an ENTITIES \e section.
+
+  When reading a memory mapped file with
+  dimeReadOptions::setLazyEntities() set, the section is only scanned
+  while reading. The offset, name and layer of each entity is
+  recorded, and the entity is decoded from the file on first access
+  through getEntity(). The names and layers are available through
+  getEntityName() and getEntityLayer() without decoding anything.
+  The file stays mapped until all entities have been decoded, or the
+  section is destructed. Methods which need all entities, like
+  write(), and methods which change the list of entities decode all
+  remaining entities first.
 */
 
 #include <dime/sections/EntitiesSection.h>
 #include <dime/Input.h>
 #include <dime/Output.h>
+#include <dime/ReadOptions.h>
 #include <dime/util/MemHandler.h>
+#include <dime/util/Dict.h>
 #include <dime/Model.h>
 #include <dime/util/Array.h>
 #include <dime/entities/Entity.h>
@@ -56,7 +69,8 @@ static const char sectionName[] = "ENTITIES";
 */
 
 dimeEntitiesSection::dimeEntitiesSection(dimeMemHandler * const memhandler)
-  : dimeSection(memhandler)
+  : dimeSection(memhandler), source( NULL ), decoder( NULL ),
+    nameDict( NULL ), numLazy( 0 )
 {
 }
 
@@ -68,8 +82,11 @@ dimeEntitiesSection::~dimeEntitiesSection()
 {
   if (!this->memHandler) {
     for (int i = 0; i < this->entities.count(); i++)
-      delete this->entities[i];
+      delete this->entities[i]; // NULL if not decoded
   }
+  delete this->decoder;
+  delete this->source;
+  delete this->nameDict;
 }
 
 //!
@@ -80,6 +97,7 @@ dimeEntitiesSection::copy(dimeModel * const model) const
   dimeMemHandler *memh = model->getMemHandler();
   dimeEntitiesSection *es = new dimeEntitiesSection(memh); 
   bool ok = es != NULL;
+  ((dimeEntitiesSection*)this)->decodeAll();
 
   int num  = this->entities.count();
   if (ok && num) {
@@ -105,36 +123,18 @@ dimeEntitiesSection::copy(dimeModel * const model) const
 bool 
 dimeEntitiesSection::read(dimeInput * const file)
 {
-  int32 groupcode;
-  const char *string;
-  bool ok = true;
-  dimeEntity *entity = NULL;
-  dimeMemHandler *memhandler = file->getMemHandler();
   this->entities.makeEmpty(1024);
 
-  while (true) {
-    if (!file->readGroupCode(groupcode) || groupcode != 0) {
-      fprintf( stderr, "Error reading groupcode: %d.\n", groupcode);
-      ok = false;
-      break;
-    }
-    string = file->readString();
-    if (!strcmp(string, "ENDSEC")) break;
-
-    entity = dimeEntity::createEntity(string, memhandler);
-    if (entity == NULL) {
-      fprintf( stderr, "Error creating entity: %s.\n", string);
-      ok = false;
-      break;
-    }
-    if (!entity->read(file)) {
-      fprintf( stderr, "Error reading entity: %s.\n", string);
-      ok = false;
-      break;
-    }
-    this->entities.append(entity);
+  if (file->options && file->options->getLazyEntities()) {
+    dimeInput *input = new dimeInput;
+    if (input->retainMapping(file)) return this->readLazy(file, input);
+    delete input; // not memory mapped, read as usual
   }
-  return ok;
+  if (file->getNumThreads() > 1) {
+    return dimeEntity::readEntitiesParallel(file, this->entities);
+  }
+  // also handles the read options, see dimeReadOptions
+  return dimeEntity::readEntities(file, this->entities, "ENDSEC");
 }
 
 //!
@@ -147,6 +147,7 @@ dimeEntitiesSection::write(dimeOutput * const file)
   file->writeGroupCode(2);
   file->writeString(sectionName);
  
+  this->decodeAll();
   int i, n = this->entities.count();
   for (i = 0; i < n; i++) {
     if (!this->entities[i]->write(file)) break;
@@ -176,8 +177,10 @@ void
 dimeEntitiesSection::fixReferences(dimeModel * const model)
 {
   int i, n = this->entities.count();
-  for (i = 0; i < n; i++) 
-    this->entities[i]->fixReferences(model);
+  for (i = 0; i < n; i++) {
+    // entities not decoded are fixed in decodeEntity()
+    if (this->entities[i]) this->entities[i]->fixReferences(model);
+  }
 }
 
 //!
@@ -186,6 +189,7 @@ int
 dimeEntitiesSection::countRecords() const
 {
   int cnt = 0;
+  ((dimeEntitiesSection*)this)->decodeAll();
   int n = this->entities.count();
   for (int i = 0; i < n; i++)
     cnt += this->entities[i]->countRecords();
@@ -212,16 +216,44 @@ dimeEntitiesSection::getNumEntities() const
 }
 
 /*!
-  Returns the entity at index \a idx.
+  Returns the entity at index \a idx. The entity is decoded if it was
+  not decoded while reading.
 */
 
 dimeEntity *
 dimeEntitiesSection::getEntity(const int idx)
 {
   assert(idx >= 0 && idx < this->entities.count());
+  if (this->entities[idx] == NULL) return this->decodeEntity(idx);
   return this->entities[idx];
 }
 
+/*!
+  Returns the name of the entity at index \a idx, without decoding
+  the entity.
+*/
+
+const char *
+dimeEntitiesSection::getEntityName(const int idx) const
+{
+  assert(idx >= 0 && idx < this->entities.count());
+  if (this->entities[idx]) return this->entities[idx]->getEntityName();
+  return this->names[idx];
+}
+
+/*!
+  Returns the layer of the entity at index \a idx, without decoding
+  the entity.
+*/
+
+const dimeLayer *
+dimeEntitiesSection::getEntityLayer(const int idx) const
+{
+  assert(idx >= 0 && idx < this->entities.count());
+  if (this->entities[idx]) return this->entities[idx]->getLayer();
+  return this->layers[idx];
+}
+
 /*!
   Removes (and deletes if no memory handler is used) the entity at index \a idx.
 */
@@ -230,6 +262,7 @@ void
 dimeEntitiesSection::removeEntity(const int idx)
 {
   assert(idx >= 0 && idx < this->entities.count());
+  this->decodeAll();
   if (!this->memHandler) delete this->entities[idx];
   this->entities.removeElem(idx);
 }
@@ -245,6 +278,7 @@ dimeEntitiesSection::removeEntity(const int idx)
 void 
 dimeEntitiesSection::insertEntity(dimeEntity * const entity, const int idx)
 {
+  this->decodeAll();
   if (idx < 0) this->entities.append(entity);
   else {
     assert(idx <= this->entities.count());
@@ -252,3 +286,90 @@ dimeEntitiesSection::insertEntity(dimeEntity * const entity, const int idx)
   }
 }
 
+//
+// Scans the section, recording where each entity starts instead of
+// reading it. input has taken over the memory mapping of file, and
+// is used to decode the entities later.
+//
+
+bool
+dimeEntitiesSection::readLazy(dimeInput * const file, dimeInput * const input)
+{
+  delete this->source;
+  delete this->nameDict;
+  this->source = input;
+  this->nameDict = new dimeDict(101);
+  if (this->decoder == NULL) this->decoder = new dimeInput;
+  this->offsets.setCount(0);
+  this->positions.setCount(0);
+  this->names.setCount(0);
+  this->layers.setCount(0);
+
+  dimeArray <size_t> ends(1024);
+  bool ok = dimeEntity::scanEntities(file, NULL, this->offsets, ends,
+                                     this->positions, this->nameDict,
+                                     &this->names, &this->layers);
+  this->numLazy = this->offsets.count();
+  // the mapping is kept, file is still reading it
+  for (int i = 0; i < this->numLazy; i++) this->entities.append(NULL);
+  if (!ok) fprintf(stderr, "Error reading section: ENTITIES.\n");
+  return ok;
+}
+
+//
+// Decodes the entity at index idx from the memory mapped file. The
+// mapping is released when all entities have been decoded.
+//
+
+dimeEntity *
+dimeEntitiesSection::decodeEntity(const int idx)
+{
+  dimeInput *in = this->decoder;
+  int32 groupcode;
+  const char *string;
+  dimeEntity *entity = NULL;
+  bool ok = in->initPart(this->source, this->offsets[idx],
+                         this->positions[idx], this->memHandler) &&
+    in->readGroupCode(groupcode) && groupcode == 0 &&
+    (string = in->readString()) != NULL;
+  if (ok) {
+    entity = dimeEntity::createEntity(string, this->memHandler);
+    ok = entity != NULL && entity->read(in);
+  }
+  if (!ok) {
+    fprintf(stderr, "Error decoding entity at line: %lld.\n",
+            (long long) this->positions[idx]);
+    if (!this->memHandler) delete entity;
+    // keep the section consistent, the entity is replaced by an empty one
+    entity = dimeEntity::createEntity(this->names[idx], this->memHandler);
+  }
+  else entity->fixReferences(in->getModel());
+  this->entities[idx] = entity;
+
+  if (--this->numLazy == 0) {
+    delete this->decoder;
+    this->decoder = NULL;
+    delete this->source;
+    this->source = NULL;
+    delete this->nameDict;
+    this->nameDict = NULL;
+    this->offsets.freeMemory();
+    this->positions.freeMemory();
+    this->names.freeMemory();
+    this->layers.freeMemory();
+  }
+  return entity;
+}
+
+//
+// Decodes all entities not decoded yet.
+//
+
+void
+dimeEntitiesSection::decodeAll()
+{
+  int n = this->entities.count();
+  for (int i = 0; i < n && this->numLazy > 0; i++) {
+    if (this->entities[i] == NULL) this->decodeEntity(i);
+  }
+}
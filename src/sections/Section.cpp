@@ -46,6 +46,7 @@
 #include <dime/sections/Section.h>
 #include <string.h>
 #include <dime/util/MemHandler.h>
+#include <dime/util/Registry.h>
 #include <dime/sections/UnknownSection.h>
 #include <dime/sections/EntitiesSection.h>
 #include <dime/sections/HeaderSection.h>
@@ -76,32 +77,74 @@ dimeSection::~dimeSection()
 {
 }
 
+//
+// Factories for the built-in sections.
+//
+
+template <class T> static dimeSection *
+dime_create_section(const char * const, dimeMemHandler * const memhandler)
+{
+  return new T(memhandler);
+}
+
+static bool
+dime_register_sections(dimeRegistry<dimeSectionFactory*> &registry)
+{
+  registry.enter("HEADER", dime_create_section<dimeHeaderSection>);
+#if 0 // passthrough for the moment. I can't imaging anybody is using them 
+  registry.enter("CLASSES", dime_create_section<dimeClassesSection>);
+  registry.enter("OBJECTS", dime_create_section<dimeObjectsSection>);
+#endif
+  registry.enter("TABLES", dime_create_section<dimeTablesSection>);
+  registry.enter("BLOCKS", dime_create_section<dimeBlocksSection>);
+  registry.enter("ENTITIES", dime_create_section<dimeEntitiesSection>);
+  return true;
+}
+
+//
+// Returns the section factories, see dime_entity_registry().
+//
+
+static dimeRegistry<dimeSectionFactory*> &
+dime_section_registry()
+{
+  static dimeRegistry<dimeSectionFactory*> registry;
+  static bool registered = dime_register_sections(registry);
+  (void) registered;
+  return registry;
+}
+
 /*!
   Static function used to create the correct section object
-  from a text string.
+  from a text string. Sections with no registered factory are
+  created as dimeUnknownSection.
+
+  \sa registerSection()
 */
 
 dimeSection *
 dimeSection::createSection(const char * const sectionname,
 			  dimeMemHandler *memhandler)
 {
-  if (!strcmp(sectionname, "HEADER"))
-    return new dimeHeaderSection(memhandler);
-#if 0 // passthrough for the moment. I can't imaging anybody is using them 
-  if (!strcmp(sectionname, "CLASSES"))
-    return new dimeClassesSection(memhandler);
-  if (!strcmp(sectionname, "OBJECTS"))
-    return new dimeObjectsSection(memhandler);
-#endif
-  if (!strcmp(sectionname, "TABLES"))
-    return new dimeTablesSection(memhandler);
-  if (!strcmp(sectionname, "BLOCKS"))
-    return new dimeBlocksSection(memhandler);
-  if (!strcmp(sectionname, "ENTITIES"))
-    return new dimeEntitiesSection(memhandler);
+  dimeSectionFactory *factory = dime_section_registry().find(sectionname);
+  if (factory) return factory(sectionname, memhandler);
   return new dimeUnknownSection(sectionname, memhandler);
 }
 
+/*!
+  Registers \a factory to create sections named \a sectionname,
+  replacing the factory of a built-in section if there is one. Setting
+  \a factory to NULL makes the section be read as dimeUnknownSection.
+  Factories should be registered before any file is read.
+*/
+
+void
+dimeSection::registerSection(const char * const sectionname,
+                             dimeSectionFactory * const factory)
+{
+  dime_section_registry().enter(sectionname, factory);
+}
+
 //!
 
 bool 
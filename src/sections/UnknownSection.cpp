@@ -115,7 +115,7 @@ dimeUnknownSection::read(dimeInput * const file)
     record = dimeRecord::readRecord(file);
     if (record == NULL) {
       fprintf(stderr,"could not create/read record (dimeUnknownSection.cpp)"
-              "line: %d\n", file->getFilePosition());
+              "line: %lld\n", (long long) file->getFilePosition());
       ok = false;
       break;
     } 
@@ -43,6 +43,7 @@
 #include <dime/Input.h>
 #include <dime/Output.h>
 #include <dime/util/MemHandler.h>
+#include <dime/util/Registry.h>
 #include <dime/Model.h>
 
 #include <string.h>
@@ -94,23 +95,69 @@ dimeTableEntry::read(dimeInput * const file)
   return dimeRecordHolder::read(file);
 }
 
+//
+// Factories for the built-in table entries.
+//
+
+template <class T> static dimeTableEntry *
+dime_create_table_entry(const char * const, dimeMemHandler * const memhandler)
+{
+  return new(memhandler) T;
+}
+
+static bool
+dime_register_table_entries(dimeRegistry<dimeTableEntryFactory*> &registry)
+{
+  registry.enter("LAYER", dime_create_table_entry<dimeLayerTable>);
+  // UCS is not used for the moment
+  //registry.enter("UCS", dime_create_table_entry<dimeUCSTable>);
+  return true;
+}
+
+//
+// Returns the table entry factories, see dime_entity_registry().
+//
+
+static dimeRegistry<dimeTableEntryFactory*> &
+dime_table_entry_registry()
+{
+  static dimeRegistry<dimeTableEntryFactory*> registry;
+  static bool registered = dime_register_table_entries(registry);
+  (void) registered;
+  return registry;
+}
+
 /*!
-  Static function that creates a table based on its name. 
+  Static function that creates a table based on its name. Tables with
+  no registered factory are created as dimeUnknownTable.
+
+  \sa registerTableEntry()
 */
 
 dimeTableEntry *
 dimeTableEntry::createTableEntry(const char * const name, 
 				dimeMemHandler * const memhandler)
 {
-  if (!strcmp(name, "LAYER")) {
-    return new(memhandler) dimeLayerTable;
-  }
-  //if (!strcmp(name, "UCS")) // UCS is not used for the moment
-  //  return new(memhandler) dimeUCSTable;
-
+  dimeTableEntryFactory *factory = dime_table_entry_registry().find(name);
+  if (factory) return factory(name, memhandler);
   return new(memhandler) dimeUnknownTable(name, memhandler);
 }
 
+/*!
+  Registers \a factory to create table entries named \a name,
+  replacing the factory of a built-in table if there is one. Setting
+  \a factory to NULL makes the entries be read as dimeUnknownTable.
+  The factory must allocate the entry with \a memhandler. Factories
+  should be registered before any file is read.
+*/
+
+void
+dimeTableEntry::registerTableEntry(const char * const name,
+                                   dimeTableEntryFactory * const factory)
+{
+  dime_table_entry_registry().enter(name, factory);
+}
+
 /*!
   Returns the number of records for this table. Tables overloading 
   this function should first count the number of records they will write,
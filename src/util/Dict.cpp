@@ -34,7 +34,11 @@
   \class dimeDict dime/util/Dict.h
   \brief The dimeDict class is internal / private.
 
-  It offers quick (hashing) lookup for strings.
+  It offers quick (hashing) lookup for strings. Each string is stored
+  once, together with its entry, in memory owned by the dictionary.
+  The string pointers returned are unique for each string, and stay
+  valid until clear() is called, also after the entry is removed, so
+  they can be compared instead of the strings.
 */
 
 /*!
@@ -43,6 +47,7 @@
 */
 
 #include <dime/util/Dict.h>
+#include <dime/util/MemHandler.h>
 #include <stdio.h>
 
 /*!
@@ -50,6 +55,7 @@
 */
 
 dimeDict::dimeDict(const int entries)
+  : memhandler( NULL )
 {
   this->tableSize = entries;
   this->buckets = new dimeDictEntry *[tableSize];
@@ -63,7 +69,7 @@ dimeDict::dimeDict(const int entries)
 
 dimeDict::~dimeDict()
 {
-  clear();
+  delete this->memhandler;
   delete [] buckets;
 }
 
@@ -74,16 +80,8 @@ dimeDict::~dimeDict()
 void
 dimeDict::clear()
 {
-  int i;
-  dimeDictEntry *entry, *nextEntry;
-
-  for(i = 0; i < tableSize; i++) {
-    for(entry = buckets[i]; entry != NULL; entry = nextEntry) {
-      nextEntry = entry->next;
-      delete entry;
-    }
-    buckets[i] = NULL;
-  }
+  for (int i = 0; i < tableSize; i++) buckets[i] = NULL;
+  if (this->memhandler) this->memhandler->reset();
 }
 
 /*!
@@ -96,12 +94,12 @@ dimeDict::clear()
 const char *
 dimeDict::enter(const char * const key, void *value)
 {
-  dimeDictEntry *&entry = findEntry(key);
+  unsigned int hash;
+  dimeDictEntry *&entry = findEntry(key, hash);
   
   if(entry == NULL) {
-    entry = new dimeDictEntry(key, value);
+    entry = newEntry(key, hash, value);
     if (entry == NULL) return NULL;
-    entry->next = NULL;
     return entry->key;
   }
   else {
@@ -119,15 +117,15 @@ dimeDict::enter(const char * const key, void *value)
 bool 
 dimeDict::enter(const char * const key, char *&ptr, void *value)
 {
-  dimeDictEntry *&entry = findEntry(key);
+  unsigned int hash;
+  dimeDictEntry *&entry = findEntry(key, hash);
   
   if(entry == NULL) {
-    entry = new dimeDictEntry(key, value);
+    entry = newEntry(key, hash, value);
     if (entry == NULL) {
       ptr = NULL;
       return false;
     }
-    entry->next = NULL;
     ptr = entry->key;
     return true;
   }
@@ -146,7 +144,8 @@ dimeDict::enter(const char * const key, char *&ptr, void *value)
 const char *
 dimeDict::find(const char * const key) const
 {
-  dimeDictEntry *&entry = findEntry(key);
+  unsigned int hash;
+  dimeDictEntry *&entry = findEntry(key, hash);
   if (entry) 
     return entry->key;
   return NULL;
@@ -159,7 +158,8 @@ dimeDict::find(const char * const key) const
 bool
 dimeDict::find(const char * const key, void *&value) const
 {
-  dimeDictEntry *&entry = findEntry(key);
+  unsigned int hash;
+  dimeDictEntry *&entry = findEntry(key, hash);
 
   if(entry == NULL) {
     value = NULL;
@@ -172,21 +172,20 @@ dimeDict::find(const char * const key, void *&value) const
 }
 
 /*!
-  Remove \a key from the dictionary.
+  Remove \a key from the dictionary. The memory used by the entry is
+  not reclaimed until clear() is called.
 */
 
 bool
 dimeDict::remove(const char * const key)
 {
-  dimeDictEntry *&entry = findEntry(key);
-  dimeDictEntry *tmp;
+  unsigned int hash;
+  dimeDictEntry *&entry = findEntry(key, hash);
 
   if(entry == NULL)
     return false;
   else {
-    tmp = entry;
     entry = entry->next;
-    delete tmp;
     return true;
   }
 }
@@ -194,31 +193,56 @@ dimeDict::remove(const char * const key)
 // private funcs
 
 dimeDictEntry *&
-dimeDict::findEntry(const char * const key) const
+dimeDict::findEntry(const char * const key, unsigned int &hash) const
 {
   dimeDictEntry **entry;
 
-  entry = &buckets[bucketNr(key) % tableSize];
+  hash = hashKey(key);
+  entry = &buckets[hash % tableSize];
   
   while(*entry != NULL) {
-    if(strcmp((*entry)->key, key) == 0) break;
+    // the keys are only compared when the hash values are equal
+    if ((*entry)->hash == hash && strcmp((*entry)->key, key) == 0) break;
     entry = &(*entry)->next;
   }
   return *entry;
 }
 
+//
+// Allocates an entry, with the key stored right after it.
+//
+
+dimeDictEntry *
+dimeDict::newEntry(const char * const key, const unsigned int hash,
+                   void *value)
+{
+  if (this->memhandler == NULL) this->memhandler = new dimeMemHandler;
+  size_t len = strlen(key) + 1;
+  dimeDictEntry *entry = (dimeDictEntry*)
+    this->memhandler->allocMem((int) (sizeof(dimeDictEntry) + len),
+                               (int) sizeof(void*));
+  if (entry == NULL) return NULL;
+  entry->next = NULL;
+  entry->hash = hash;
+  entry->key = (char*) (entry + 1);
+  memcpy(entry->key, key, len);
+  entry->value = value;
+  return entry;
+}
+
+//
+// The FNV-1a hash, which also spreads short, similar keys well.
+//
+
 unsigned int
-dimeDict::bucketNr(const char *s) const
+dimeDict::hashKey(const char *s)
 {
-  unsigned int total, shift;
-  total = shift = 0;
+  unsigned int hash = 2166136261u;
   while (*s) {
-    total = total ^ ((*s) << shift);
-    shift+=5;
-    if (shift>24) shift -= 24;
-    s++;
+    hash ^= (unsigned char) *s++;
+    hash *= 16777619u;
   }
-  return total % tableSize;
+  return hash;
 }
 
 /*
@@ -60,6 +60,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
 
 #define MEMBLOCK_SIZE 65536 // the bigger the value, the less overhead
 
@@ -110,7 +112,8 @@ private:
 */
 
 dimeMemHandler::dimeMemHandler()
-  : bigmemnode( NULL )
+  : bigmemnode( NULL ), adopted( NULL ), nextAdopted( NULL ),
+    borrowBegin( NULL ), borrowEnd( NULL )
 {
   this->memnode = new dimeMemNode(MEMBLOCK_SIZE, NULL);
 }
@@ -136,6 +139,13 @@ dimeMemHandler::~dimeMemHandler()
     delete curr;
     curr = next;
   }
+
+  dimeMemHandler *handler = this->adopted;
+  while (handler) {
+    dimeMemHandler *nexthandler = handler->nextAdopted;
+    delete handler;
+    handler = nexthandler;
+  }
 }
 
 /*!
@@ -151,12 +161,17 @@ dimeMemHandler::initOk() const
 
 /*!
   Allocates memory for the string, copies string into memory, and
-  returns the new string pointer.
+  returns the new string pointer. Strings in the data set with
+  borrowStrings() are returned as they are, and must not be modified.
 */
 
 char *
 dimeMemHandler::stringAlloc(const char * const string)
 {
+  if ((uintptr_t) string >= (uintptr_t) this->borrowBegin &&
+      (uintptr_t) string < (uintptr_t) this->borrowEnd) {
+    return (char*) string;
+  }
   int len = strlen(string)+1;
   char *ret = (char*)this->allocMem(len, 1);
   if (ret) {
@@ -193,3 +208,81 @@ dimeMemHandler::allocMem(const int size, const int alignment)
   }
   return ret;
 }
+
+/*!
+  Takes ownership of \a handler, which will be deleted, and its
+  memory freed, when this memory handler is deleted. This is used to
+  keep the memory allocated by temporary memory handlers, for
+  instance one for each thread reading a file, together with the
+  memory of the model.
+*/
+
+void
+dimeMemHandler::adopt(dimeMemHandler * const handler)
+{
+  assert(handler != this && handler->nextAdopted == NULL);
+  handler->nextAdopted = this->adopted;
+  this->adopted = handler;
+}
+
+/*!
+  Makes stringAlloc() return strings found in the \a size bytes at \a
+  data instead of copying them. The data must be kept unchanged until
+  the strings are no longer used, which dimeModel::read() arranges
+  when dimeReadOptions::setBorrowStrings() is set.
+*/
+
+void
+dimeMemHandler::borrowStrings(const void * const data, const size_t size)
+{
+  this->borrowBegin = (const char*) data;
+  this->borrowEnd = this->borrowBegin + size;
+}
+
+/*!
+  Borrows the same data as \a handler.
+*/
+
+void
+dimeMemHandler::borrowStrings(const dimeMemHandler * const handler)
+{
+  this->borrowBegin = handler->borrowBegin;
+  this->borrowEnd = handler->borrowEnd;
+}
+
+/*!
+  Frees all memory allocated so far, except for one memory block
+  which is kept for the next allocations. All pointers returned from
+  this memory handler will be invalid after this call. Useful when
+  the same kind of short-lived data is allocated over and over again.
+*/
+
+void
+dimeMemHandler::reset()
+{
+  dimeMemNode *curr = this->memnode->next;
+  dimeMemNode *next;
+  while (curr) {
+    next = curr->next;
+    delete curr;
+    curr = next;
+  }
+  this->memnode->next = NULL;
+  this->memnode->currPos = 0;
+
+  curr = this->bigmemnode;
+  while (curr) {
+    next = curr->next;
+    delete curr;
+    curr = next;
+  }
+  this->bigmemnode = NULL;
+
+  dimeMemHandler *handler = this->adopted;
+  while (handler) {
+    dimeMemHandler *nexthandler = handler->nextAdopted;
+    delete handler;
+    handler = nexthandler;
+  }
+  this->adopted = NULL;
+}
@@ -0,0 +1,182 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+//
+// entitystream - reads MTEXT entities, in a block and in the ENTITIES
+// section, with dimeEntityStream. Checks the text of each entity, and
+// that the number of heap allocations alive does not grow with the
+// number of entities read.
+//
+
+#include <dime/Input.h>
+#include <dime/EntityStream.h>
+#include <dime/entities/Block.h>
+#include <dime/entities/Text.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <string>
+
+static std::atomic<long> live_allocs(0);
+
+void *
+operator new(size_t size)
+{
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  live_allocs++;
+  return p;
+}
+
+void *
+operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void
+operator delete(void *p) noexcept
+{
+  if (p) {
+    live_allocs--;
+    free(p);
+  }
+}
+
+void
+operator delete[](void *p) noexcept
+{
+  operator delete(p);
+}
+
+void
+operator delete(void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+void
+operator delete[](void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+#define NUMBLOCKTEXTS 50
+#define NUMTEXTS 2000
+
+//
+// The text of MTEXT number i, long enough to be stored on the heap
+// by std::string.
+//
+
+static std::string
+text_string(const int i)
+{
+  char tmp[32];
+  snprintf(tmp, sizeof(tmp), "text %d ", i);
+  return std::string(tmp) + std::string(100, 'x');
+}
+
+static void
+add_mtext(std::string &data, const int i)
+{
+  data += "  0\nMTEXT\n  8\n0\n 10\n1.0\n 20\n2.0\n 30\n0.0\n 40\n2.5\n";
+  data += "  7\n" + std::string(100, 's') + "\n";
+  data += "  1\n" + text_string(i) + "\n";
+}
+
+static bool
+check_mtext(dimeEntity * const entity, const int i)
+{
+  if (entity->typeId() != dimeBase::dimeMTextType ||
+      text_string(i) != ((dimeMText*) entity)->GetText()) {
+    fprintf(stderr, "entity %d is not the expected MTEXT\n", i);
+    return false;
+  }
+  return true;
+}
+
+int
+main()
+{
+  std::string data;
+  data += "  0\nSECTION\n  2\nBLOCKS\n";
+  data += "  0\nBLOCK\n  8\n0\n  2\nTEXTS\n 70\n0\n";
+  data += " 10\n0.0\n 20\n0.0\n 30\n0.0\n  3\nTEXTS\n";
+  for (int i = 0; i < NUMBLOCKTEXTS; i++) add_mtext(data, i);
+  data += "  0\nENDBLK\n  8\n0\n";
+  data += "  0\nENDSEC\n  0\nSECTION\n  2\nENTITIES\n";
+  for (int i = 0; i < NUMTEXTS; i++) add_mtext(data, i);
+  data += "  0\nENDSEC\n  0\nEOF\n";
+
+  bool ok = true;
+  long first = 0;
+  {
+    dimeInput in;
+    if (!in.setBuffer(data.data(), data.size())) return 1;
+    dimeEntityStream stream;
+    if (!stream.open(&in)) {
+      fprintf(stderr, "could not open the stream\n");
+      return 1;
+    }
+    dimeEntity *entity = stream.next();
+    if (!entity || entity->typeId() != dimeBase::dimeBlockType ||
+        ((dimeBlock*) entity)->getNumEntities() != NUMBLOCKTEXTS) {
+      fprintf(stderr, "the first entity is not the block\n");
+      return 1;
+    }
+    for (int i = 0; i < NUMBLOCKTEXTS; i++) {
+      ok = check_mtext(((dimeBlock*) entity)->getEntity(i), i) && ok;
+    }
+    int n = 0;
+    while (ok && (entity = stream.next()) != NULL) {
+      ok = check_mtext(entity, n);
+      if (n == 10) first = live_allocs;
+      n++;
+    }
+    ok = ok && !stream.hasError();
+    if (n != NUMTEXTS) {
+      fprintf(stderr, "read %d of %d MTEXT entities\n", n, NUMTEXTS);
+      ok = false;
+    }
+    // a few allocations are allowed for arrays that grow while reading
+    if (live_allocs > first + 10) {
+      fprintf(stderr, "%ld allocations alive after entity 10, %ld after "
+              "entity %d\n", first, (long) live_allocs, n - 1);
+      ok = false;
+    }
+  }
+  printf("entitystream: %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
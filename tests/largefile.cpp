@@ -0,0 +1,253 @@
+/**************************************************************************\
+ * Copyright (c) Kongsberg Oil & Gas Technologies AS
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**************************************************************************/
+
+//
+// largefile - writes a binary DXF file larger than 4 GB, and reads it
+// back with dimeEntityStream, from the file and memory mapped. Checks
+// that all entities are read, that the file position ends at the
+// file size, and that the progress values follow the position past
+// 2^32 bytes. Built when DIME_BUILD_LARGEFILE_TEST is ON.
+//
+
+#include <dime/Input.h>
+#include <dime/EntityStream.h>
+#include <dime/entities/Entity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static int
+usage(char *progname)
+{
+  fprintf(stderr,
+	  "Usage: %s [options] <file>\n\n"
+	  "Writes a binary DXF file larger than 4 GB to file, reads it,\n"
+	  "and removes it.\n\n"
+	  "Options:\n"
+	  "-s <num>     Size of the file in MB (default 4608)\n"
+	  "-k           Keep the file\n\n",
+	  progname);
+  return -1;
+}
+
+//
+// Binary DXF records, with 8 bit group codes.
+//
+
+static void
+add_string(std::string &data, const int code, const char *str)
+{
+  data += (char) code;
+  data.append(str, strlen(str) + 1);
+}
+
+static void
+add_double(std::string &data, const int code, const double val)
+{
+  uint64 bits;
+  memcpy(&bits, &val, 8);
+  data += (char) code;
+  // binary DXF is little endian
+  for (int i = 0; i < 8; i++) data += (char) (bits >> (8 * i));
+}
+
+//
+// Writes POINT entities until the file is at least size bytes.
+// Returns the number of entities written, or -1 on error.
+//
+
+static int64
+write_file(const char *filename, const int64 size, int64 &filesize)
+{
+  FILE *fp = fopen(filename, "wb");
+  if (!fp) {
+    fprintf(stderr, "Error opening file for writing: %s\n", filename);
+    return -1;
+  }
+  std::string ent;
+  add_string(ent, 0, "POINT");
+  add_string(ent, 8, std::string(200, 'L').c_str());
+  add_double(ent, 10, 1.0);
+  add_double(ent, 20, 2.0);
+  add_double(ent, 30, 3.0);
+
+  const int perblock = (1 << 20) / (int) ent.size();
+  std::string block;
+  for (int i = 0; i < perblock; i++) block += ent;
+
+  std::string data("AutoCAD Binary DXF\r\n\032", 22);
+  add_string(data, 0, "SECTION");
+  add_string(data, 2, "ENTITIES");
+  bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+  filesize = (int64) data.size();
+
+  int64 count = 0;
+  while (ok && filesize < size) {
+    ok = fwrite(block.data(), 1, block.size(), fp) == block.size();
+    filesize += (int64) block.size();
+    count += perblock;
+  }
+  data.clear();
+  add_string(data, 0, "ENDSEC");
+  add_string(data, 0, "EOF");
+  if (ok) ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+  filesize += (int64) data.size();
+  if (fclose(fp) != 0) ok = false;
+  if (!ok) {
+    fprintf(stderr, "Error writing %s\n", filename);
+    return -1;
+  }
+  return count;
+}
+
+struct progress_data {
+  dimeInput *in;
+  int64 filesize;
+  float last;
+  int64 lastpos;
+  int64 maxpos;
+  int calls;
+  bool ok;
+};
+
+static int
+progress_cb(float val, void *data)
+{
+  progress_data *pd = (progress_data*) data;
+  int64 pos = pd->in->getFilePosition();
+  // the progress is reported from the read offset, which may be a
+  // buffer ahead of the position of the last value
+  double rel = (double) pos / (double) pd->filesize;
+  if (val < pd->last || val > 1.0f || pos < pd->lastpos ||
+      val < rel - 0.02 || val > rel + 0.02) {
+    fprintf(stderr, "progress went from %g at %lld to %g at %lld\n",
+	    pd->last, (long long) pd->lastpos, val, (long long) pos);
+    pd->ok = false;
+  }
+  pd->last = val;
+  pd->lastpos = pos;
+  if (pos > pd->maxpos) pd->maxpos = pos;
+  pd->calls++;
+  return 1;
+}
+
+//
+// Reads all entities of the file, and checks the count, the final
+// position and the progress values.
+//
+
+static bool
+read_file(const char *filename, const int flags, const char *name,
+	  const int64 count, const int64 filesize)
+{
+  dimeInput in;
+  if (!in.setFile(filename, flags)) {
+    fprintf(stderr, "Error opening file for reading: %s\n", filename);
+    return false;
+  }
+  progress_data pd = { &in, filesize, 0.0f, 0, 0, 0, true };
+  in.setCallback(progress_cb, &pd);
+
+  dimeEntityStream stream;
+  int64 n = 0;
+  if (stream.open(&in)) {
+    while (stream.next()) n++;
+  }
+  bool ok = pd.ok && !stream.hasError();
+  if (n != count) {
+    fprintf(stderr, "%s: read %lld of %lld entities\n", name,
+	    (long long) n, (long long) count);
+    ok = false;
+  }
+  if (in.getFilePosition() != filesize) {
+    fprintf(stderr, "%s: file position %lld, file size %lld\n", name,
+	    (long long) in.getFilePosition(), (long long) filesize);
+    ok = false;
+  }
+  const int64 limit = (int64) 1 << 32;
+  if (filesize > limit && (pd.maxpos <= limit ||
+			   pd.last * (double) filesize <= (double) limit)) {
+    fprintf(stderr, "%s: progress ended at %g, position %lld\n", name,
+	    pd.last, (long long) pd.maxpos);
+    ok = false;
+  }
+  printf("%s: %lld entities, position %lld, %d progress calls, "
+	 "last %g at %lld: %s\n", name, (long long) n,
+	 (long long) in.getFilePosition(), pd.calls, pd.last,
+	 (long long) pd.lastpos, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+  int64 size = (int64) 4608 << 20;
+  bool keep = false;
+  const char *filename = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-' || argv[i][1] == 0) {
+      if (filename) return usage(argv[0]);
+      filename = argv[i];
+    }
+    else {
+      switch (argv[i][1]) {
+      case 's':
+	i++;
+	if (i >= argc || (size = (int64) atoi(argv[i]) << 20) <= 0) {
+	  return usage(argv[0]);
+	}
+	break;
+      case 'k':
+	keep = true;
+	break;
+      default:
+	return usage(argv[0]);
+      }
+    }
+  }
+  if (!filename) return usage(argv[0]);
+
+  int64 filesize;
+  const int64 count = write_file(filename, size, filesize);
+  if (count < 0) {
+    remove(filename);
+    return 1;
+  }
+  bool ok = read_file(filename, 0, "read", count, filesize);
+#ifdef DIME_INPUT_MMAP
+  ok = read_file(filename, DIME_INPUT_MMAP, "mmap", count, filesize) && ok;
+#endif
+  if (!keep) remove(filename);
+  return ok ? 0 : 1;
+}